@@ -2,10 +2,21 @@
 #include "CWAFProcApp.h"
 #include "mempool.h"
 #include "hashTable.h"
+#include "hashShard.h"
+#include "hashReplica.h"
+#include "hashSnapshot.h"
+#include "hashTrace.h"
 #include "hash.h"
 #include <rte_jhash.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <errno.h>
+#include <arpa/inet.h>
+
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
 
 
 extern uint64_t g_ullOneSecondCycle;
@@ -22,8 +33,96 @@ struct HashTableOps g_stAlgHtblOps =
 	.assignKey = assign_key,
 	.assignValue = assign_value,
 	.assessFunc = assess_node,
+	/*older g++ only accepts designators without gaps*/
+	.expireFunc = NULL,
+	.keySize = 0,
+	.valueSize = 0,
+	.mallocSocketFunc = rte_malloc_socket_wrap,
+	.socket = 0,
+	/*new clients are staged per lcore and written to the shards in batches, indexed by address for AlgInvalidateIp*/
+	.flags = HASH_TABLE_F_WRITE_COMBINE | HASH_TABLE_F_IP_INDEX,
+	.keyHashFunc = key_hash,
+	/*the nodes go back to the mempool of the lcore which inserted them*/
+	.evictFunc = release_node,
+	.keyIpFunc = key_ip,
+};
+
+/*the replicas hold the key and value inline, they need the sizes*/
+struct HashTableOps g_stAlgReplicaOps =
+{
+	.cmp = compare,
+	.hash = hash,
+	.mallocFunc = rte_malloc_wrap,
+	.freeFunc = rte_free_wrap,
+	.assignKey = assign_key,
+	.assignValue = assign_value,
+	.assessFunc = assess_node,
+	.expireFunc = NULL,
+	.keySize = sizeof(struct key),
+	.valueSize = sizeof(struct value),
+	.mallocSocketFunc = rte_malloc_socket_wrap,
+	.socket = 0,
+	.flags = 0,
+	.keyHashFunc = key_hash,
+	.evictFunc = NULL,
+	.keyIpFunc = NULL,
 };
 
+struct hashShard *g_pstAlgShard = NULL;
+struct hashReplica *g_pstAlgReplica = NULL;
+struct hashTrace *g_pstAlgTrace = NULL;
+
+/*set while AlgInvalidateIp runs, the nodes it releases are retracted from the replicas*/
+static __thread int t_iAlgInvalidating = 0;
+
+/*
+ * Nodes of the verify table held by each tenant. A node is counted when the table keeps it, moved
+ * between tenants when the table overwrites it in place through assign_key and uncounted when the
+ * table gives it back through release_node.
+ */
+struct AlgTenant
+{
+	rte_atomic32_t count;
+	/*0 for ALG_TENANT_QUOTA*/
+	unsigned int quota;
+};
+
+static struct AlgTenant g_astAlgTenant[ALG_TENANT_SLOTS];
+
+static inline struct AlgTenant *AlgTenantAt(unsigned int tenant)
+{
+	return &g_astAlgTenant[tenant & (ALG_TENANT_SLOTS-1)];
+}
+
+/*the check is not atomic with the insert, concurrent lcores may overshoot the quota by a few nodes*/
+static inline int AlgTenantFull(unsigned int tenant)
+{
+	struct AlgTenant *t = AlgTenantAt(tenant);
+
+	return rte_atomic32_read(&t->count) >= (int32_t)(t->quota?t->quota:ALG_TENANT_QUOTA);
+}
+
+unsigned int AlgTenantOf(const char *host, unsigned int len)
+{
+	if( !host || !len )
+	{
+		return 0;
+	}
+	return rte_hash_crc(host, len, CRC32_INIT_VAL) & (ALG_TENANT_SLOTS-1);
+}
+
+void AlgTenantSetQuota(const char *host, unsigned int len, unsigned int quota)
+{
+	AlgTenantAt(AlgTenantOf(host, len))->quota = quota;
+}
+
+unsigned int AlgTenantCount(const char *host, unsigned int len)
+{
+	int32_t count = rte_atomic32_read(&AlgTenantAt(AlgTenantOf(host, len))->count);
+
+	return count > 0 ? count : 0;
+}
+
 void *rte_malloc_wrap(size_t size)
 {
 	void *addr = NULL;
@@ -39,6 +138,27 @@ void *rte_malloc_wrap(size_t size)
 	return addr;
 }
 
+void *rte_malloc_socket_wrap(size_t size, int socket)
+{
+	void *addr = NULL;
+	unsigned long nodeMask = 0;
+
+	addr = rte_malloc_wrap(size);
+	if( !addr || socket < 0 )
+	{
+		return addr;
+	}
+
+	/*pages are bound before the first touch, so they are faulted in on the node*/
+	nodeMask = 1UL << socket;
+	if( syscall(SYS_mbind, addr, size, MPOL_BIND, &nodeMask, sizeof(nodeMask)*8, 0) < 0 )
+	{
+		PERR("Mbind() to socket %d failed due to:%s\n", socket, strerror(errno));
+	}
+
+	return addr;
+}
+
 void rte_free_wrap(void *addr, int len)
 {
 	if( addr )
@@ -77,8 +197,13 @@ void assign_key(void *src, void *dst)
 
 	if( s && d )
 	{
+		/*the table only assigns a key to overwrite one of its nodes, which may change tenant*/
+		rte_atomic32_dec(&AlgTenantAt(d->tenant)->count);
+		rte_atomic32_inc(&AlgTenantAt(s->tenant)->count);
 		d->hashKey = s->hashKey;
 		d->verifyKey = s->verifyKey;
+		d->tenant = s->tenant;
+		d->ip = s->ip;
 	}
 }
 
@@ -95,6 +220,52 @@ void assign_value(void *src, void *dst)
 	}
 }
 
+/*
+ * A node given back by the table. The object goes back to the mempool of its owner, through the
+ * remote list of that mempool when another lcore reclaims it.
+ */
+void release_node(void *key, void *value, unsigned int owner)
+{
+	struct Mempool *mp = NULL;
+
+	rte_atomic32_dec(&AlgTenantAt(((struct key*)key)->tenant)->count);
+	if( t_iAlgInvalidating )
+	{
+		hash_replica_retract(g_pstAlgReplica, key);
+	}
+	if( owner < MS_MAX_LCORE )
+	{
+		mp = g_serverApp.lcoreConf[owner].mpAlg;
+	}
+	if( !mp )
+	{
+		/*owner unknown, the object is assumed to come from the mempool of this lcore*/
+		owner = rte_lcore_id();
+		mp = t_qconf ? t_qconf->mpAlg : NULL;
+	}
+	if( !mp )
+	{
+		return;
+	}
+
+	if( owner == rte_lcore_id() )
+	{
+		mempool_put_object(mp, key);
+	}
+	else
+	{
+		mempool_put_object_remote(mp, key);
+	}
+}
+
+void AlgMempoolLow(struct Mempool *mp, void *userData)
+{
+	if( g_pstAlgShard )
+	{
+		hash_shard_reclaim(g_pstAlgShard, (unsigned int)(uintptr_t)userData, ALG_RECLAIM_WANT, ALG_RECLAIM_BUDGET);
+	}
+}
+
 int compare(void *key1, void *key2)
 {
 	struct key *src = NULL;
@@ -132,17 +303,43 @@ int hash(void *data, int dLen, void *key)
 	return k->hashKey;
 }
 
-void update_value(void *v, void *userData)
+unsigned int key_hash(void *key)
 {
-	struct value *s = (struct value*)userData;
-	struct value *d = (struct value*)v;
+	return ((struct key*)key)->hashKey;
+}
 
-	if( s && d )
+uint32_t key_ip(void *key)
+{
+	return ((struct key*)key)->ip;
+}
+
+/*IPv4 address of a client in host byte order, 0 for an IPv6 client*/
+static uint32_t AlgClientIp(const char *ip)
+{
+	struct in_addr addr;
+
+	if( !ip || inet_pton(AF_INET, ip, &addr) != 1 )
 	{
-		d->status = s->status;
-		d->algorithm = s->algorithm;
-		d->count = s->count;
+		return 0;
 	}
+	return ntohl(addr.s_addr);
+}
+
+int AlgInvalidateIp(const char *ip, unsigned int prefixLen)
+{
+	struct in_addr addr;
+	int dropped = 0;
+
+	if( !g_pstAlgShard || !ip || inet_pton(AF_INET, ip, &addr) != 1 || prefixLen > 32 )
+	{
+		return -1;
+	}
+
+	t_iAlgInvalidating = 1;
+	dropped = hash_shard_invalidate_by_ip(g_pstAlgShard, ntohl(addr.s_addr), prefixLen);
+	t_iAlgInvalidating = 0;
+
+	return dropped;
 }
 
 static int CalculateCookieKey()
@@ -377,33 +574,106 @@ int ConstructResponse(int methodType)
 	return ret;
 }
 
+#define REPEAT_MAX 5
+
+struct AlgVerify
+{
+	uint32_t methodType;
+	int ret;
+	int respond;
+};
+
+static void AlgVerifyInit(void *value, void *userData)
+{
+	struct value *v = (struct value*)value;
+	struct AlgVerify *verify = (struct AlgVerify*)userData;
+
+	v->status = NODE_STATUS_INIT;
+	v->algorithm = (verify->methodType==HTTP_HDR_GET?ALG_TYPE_CAPTCHA:ALG_TYPE_HTTP_COOKIE);
+	v->count = 0;
+}
+
+/*runs under the write lock of the node, the response is constructed once it is released*/
+static void AlgVerifyUpdate(void *value, void *userData)
+{
+	struct value *v = (struct value*)value;
+	struct AlgVerify *verify = (struct AlgVerify*)userData;
+	int verifyResult = 0;
+	int algorithm = v->algorithm;
+
+	if( v->status == NODE_STATUS_TRUST )
+	{
+		verify->ret = VERIFY_SUCCESS;
+		return;
+	}
+	else if( v->status == NODE_STATUS_UNTRUST )
+	{
+		verify->ret = VERIFY_FAILED;
+		return;
+	}
+	/*check the http request */
+	if( (algorithm >= ALG_TYPE_MAX) || (algorithm < 0)
+			|| (resultCheck[algorithm] == NULL) )
+	{
+		PERR("Unsupported algorithm!\n");
+		verify->ret = VERIFY_FAILED;
+		return;
+	}
+	verifyResult = resultCheck[algorithm]();
+
+	if( verifyResult == VERIFY_FAILED )
+	{
+		if( algorithm == ALG_TYPE_CAPTCHA )
+		{
+			if( v->count > REPEAT_MAX )
+			{
+				verify->ret = VERIFY_FAILED;
+				return;
+			}
+			v->count++;
+			verify->respond = 1;
+			verify->ret = VERIFY_REPEAT;
+			return;
+		}
+		v->status = NODE_STATUS_UNTRUST;
+		verify->ret = VERIFY_FAILED;
+	}
+	else
+	{
+		v->status = NODE_STATUS_TRUST;
+		verify->ret = VERIFY_SUCCESS;
+	}
+}
+
 int DefendAlgSendBack(struct AlgParam *param)
 {
 #define HOST_LEN_MAX 128
 #define USER_AGENT_LEN_MAX 512
-#define REPEAT_MAX 5
-	int ret = VERIFY_BEGIN;
 	char *pReqHost = GetHttpDataHostPtr();
 	uint32_t ulReqHostLen = GetHttpDataHostLen();
 	char *pReqUA = GetHttpDataFieldPtr(HTTP_USER_AGENT);
 	uint32_t ulReqUALen = GetHttpDataFieldLen(HTTP_USER_AGENT);
+	unsigned int tenant = AlgTenantOf(pReqHost, ulReqHostLen);
 	char dataBuf[HOST_LEN_MAX+64+USER_AGENT_LEN_MAX] = {0};
 	const char *client_ip = NULL;
 	unsigned int copy = 0;
-	struct hashTable *htbl = NULL;
+	struct hashShard *shard = NULL;
 	struct Mempool *mp = NULL;
 	struct CCVerifyNode *obj = NULL;
-	struct value *v = NULL;
-	int update = 1;
-	struct HashNodeCopy cp;
+	struct AlgVerify verify;
+	struct UpsertCallBack callback = { AlgVerifyInit, AlgVerifyUpdate, &verify };
+	struct UpdateCallBack update = { AlgVerifyUpdate, &verify };
+	struct key k;
+	struct value v;
+	struct HashNodeCopy nodeCopy = { 0, &v };
+	struct HashSig sig;
 	int result = 0;
-	static struct UpdateCallBack fUpdate = { update_value, NULL};
 
 	uint32_t methodType = GetHttpDataPtr()->m_ulBigHttpType;
-	htbl = t_qconf->htblAlg;
+	shard = g_pstAlgShard;
 	mp = t_qconf->mpAlg;
 
-	if( !param || !htbl || !mp )
+	if( !param || !shard || !mp )
 	{
 		return VERIFY_FAILED;
 	}
@@ -424,93 +694,208 @@ int DefendAlgSendBack(struct AlgParam *param)
 	strcpy(dataBuf+copy, client_ip);
 	copy += strlen(client_ip);
 
-	obj = (CCVerifyNode*)mempool_get_object(mp);
-	if( !obj )
+	/*the slots of the client are loaded while the node is allocated*/
+	hash_shard_sig(shard, dataBuf, copy, (void*)&k, &sig);
+	k.tenant = tenant;
+	k.ip = AlgClientIp(client_ip);
+	/*a client already judged is answered from the replica on the socket of this lcore*/
+	if( hash_replica_find(g_pstAlgReplica, &sig, (void*)&k, &nodeCopy) )
 	{
-		return VERIFY_FAILED;
+		/*the table would have been asked otherwise, it is replayed as a lookup*/
+		hash_trace_record(g_pstAlgTrace, HASH_TRACE_FIND, &sig, k.verifyKey, 0, 1);
+		return v.status==NODE_STATUS_TRUST?VERIFY_SUCCESS:VERIFY_FAILED;
 	}
-	cp.value = &(obj->v);
-	if( (v = (struct value*)hash_table_find(htbl, dataBuf, copy, (void*)&(obj->k), (void*)&cp, NULL)) != NULL )
+	hash_shard_prefetch_sig(shard, &sig);
+	verify.methodType = methodType;
+	verify.ret = VERIFY_BEGIN;
+	verify.respond = 0;
+
+	/*
+	 * the site used up its quota, or no node is left even after the low watermark gave back the
+	 * oldest ones: the known clients are still answered but no new one is tracked
+	 */
+	if( AlgTenantFull(k.tenant) || !(obj = (CCVerifyNode*)mempool_get_object(mp)) )
 	{
-		v = (struct value*)cp.value;
-		if( v->status == NODE_STATUS_TRUST )
+		if( !hash_shard_find_with_sig(shard, &sig, (void*)&k, &nodeCopy, &update) )
 		{
-			if( param->expired <= cp.expired )
-			{
-				update = 0;
-			}
-			ret = VERIFY_SUCCESS;
-			goto DONE;
+			hash_trace_record(g_pstAlgTrace, HASH_TRACE_FIND, &sig, k.verifyKey, 0, 0);
+			return VERIFY_FAILED;
 		}
-		else if( v->status == NODE_STATUS_UNTRUST )
+		hash_trace_record(g_pstAlgTrace, HASH_TRACE_FIND, &sig, k.verifyKey, 0, 1);
+		result = RET_UPDATE;
+	}
+	else
+	{
+		obj->k = k;
+
+		/*one lookup either starts the verification of a new client or checks the answer of a known one*/
+		result = hash_shard_upsert_with_sig(shard, &sig, (void*)&(obj->k), (void*)&(obj->v), param->expired, &callback, &nodeCopy);
+		hash_trace_record(g_pstAlgTrace, HASH_TRACE_UPSERT, &sig, k.verifyKey, param->expired, result);
+		if( result == RET_NEW )
 		{
-			if( param->expired <= cp.expired )
-			{
-				update = 0;
-			}
-			ret = VERIFY_FAILED;
-			goto DONE;
+			rte_atomic32_inc(&AlgTenantAt(k.tenant)->count);
 		}
-		/*check the http request */
-		int verifyResult = 0;
-		int algorithm = v->algorithm;
-		if( (algorithm >= ALG_TYPE_MAX) || (algorithm < 0)
-				|| (resultCheck[algorithm] == NULL) )
+		else
+		{
+			mempool_put_object(mp, obj);
+		}
+	}
+	/*the verdict is copied to the replicas, also when the replica missed it after falling behind*/
+	if( result == RET_UPDATE && (v.status == NODE_STATUS_TRUST || v.status == NODE_STATUS_UNTRUST) )
+	{
+		hash_replica_publish(g_pstAlgReplica, (void*)&k, (void*)&v, nodeCopy.expired);
+	}
+	if( result != RET_UPDATE )
+	{
+		ConstructResponse(methodType);
+		return VERIFY_BEGIN;
+	}
+	if( verify.respond )
+	{
+		ConstructResponse(methodType);
+	}
+
+	return verify.ret;
+}
+
+void AlgMaintain(void)
+{
+	if( t_qconf && t_qconf->mpAlg )
+	{
+		mempool_reclaim_remote(t_qconf->mpAlg);
+	}
+	if( g_pstAlgShard )
+	{
+		hash_shard_maintain(g_pstAlgShard);
+	}
+	hash_replica_sync(g_pstAlgReplica, ALG_REPLICA_SYNC_BUDGET);
+}
+
+int AlgSnapshotSave(const char *path)
+{
+	char file[ALG_SNAPSHOT_PATH_MAX] = {0};
+	struct hashTable *htbl = NULL;
+	unsigned int i = 0;
+	int64_t saved = 0;
+	int total = 0;
+
+	if( !path || !g_pstAlgShard )
+	{
+		return -1;
+	}
+
+	for( ; (htbl = hash_shard_at(g_pstAlgShard, i)) != NULL; i++)
+	{
+		snprintf(file, sizeof(file), "%s.%u", path, i);
+		saved = hash_table_snapshot(htbl, file, sizeof(struct key), sizeof(struct value));
+		if( saved < 0 )
 		{
-			PERR("Unsupported algorithm!\n");
-			ret = VERIFY_FAILED;
-			goto DONE;
+			PERR("Save verify nodes to %s failed\n", file);
+			return -1;
 		}
-		verifyResult = resultCheck[algorithm]();
+		total += saved;
+	}
+	/*files left by a run with more shards*/
+	do
+	{
+		snprintf(file, sizeof(file), "%s.%u", path, i++);
+	} while( unlink(file) == 0 );
+
+	return total;
+}
 
-		if( verifyResult == VERIFY_FAILED )
+int AlgSnapshotLoad(const char *path, unsigned int part, unsigned int parts, unsigned int lcore)
+{
+	char file[ALG_SNAPSHOT_PATH_MAX] = {0};
+	struct Mempool *mp = NULL;
+	struct HashSnapshot *snap = NULL;
+	struct CCVerifyNode *obj = NULL;
+	struct CCVerifyNode rec;
+	uint64_t expired = 0;
+	unsigned int i = 0;
+	int exhausted = 0;
+	int total = 0;
+	int ret = 0;
+
+	if( lcore < MS_MAX_LCORE )
+	{
+		mp = g_serverApp.lcoreConf[lcore].mpAlg;
+	}
+	if( !path || !g_pstAlgShard || !mp )
+	{
+		return -1;
+	}
+
+	/*the nodes are owned by lcore, they are put back into its mempool*/
+	hash_table_set_owner(lcore);
+	/*the keys are routed again, the previous run may have had another number of shards*/
+	for( ; ; i++)
+	{
+		snprintf(file, sizeof(file), "%s.%u", path, i);
+		snap = hash_snapshot_load(file, part, parts, sizeof(struct key), sizeof(struct value));
+		if( !snap )
+		{
+			break;
+		}
+		while( (ret = hash_snapshot_next(snap, &rec.k, &rec.v, &expired)) > 0 )
 		{
-			if( algorithm == ALG_TYPE_CAPTCHA )
+			obj = (CCVerifyNode*)mempool_get_object(mp);
+			if( !obj )
 			{
-				if( v->count > REPEAT_MAX )
-				{
-					ret = VERIFY_FAILED;
-					goto DONE;
-				}
-				else
-				{
-					v->count++;
-					ConstructResponse(methodType);
-				}
-				ret = VERIFY_REPEAT;
-				goto DONE;
+				exhausted = 1;
+				break;
+			}
+			*obj = rec;
+			if( hash_shard_insert_key(g_pstAlgShard, (void*)&(obj->k), (void*)&(obj->v), expired) == RET_NEW )
+			{
+				rte_atomic32_inc(&AlgTenantAt(obj->k.tenant)->count);
+				total++;
+			}
+			else
+			{
+				mempool_put_object(mp, obj);
 			}
-			v->status = NODE_STATUS_UNTRUST;
-			ret = VERIFY_FAILED;
 		}
-		else
+		hash_snapshot_close(snap);
+		/*a part without records goes on with the next file*/
+		if( exhausted )
 		{
-			v->status = NODE_STATUS_TRUST;
-			ret = VERIFY_SUCCESS;
+			break;
 		}
 	}
-	else
+	/*the restored nodes are staged by this lcore, which may never maintain the shards*/
+	hash_shard_flush(g_pstAlgShard);
+	hash_table_set_owner(LCORE_ID_ANY);
+
+	return total;
+}
+
+int AlgTraceStart(void)
+{
+	if( !g_pstAlgTrace )
 	{
-		obj->v.status = NODE_STATUS_INIT;
-		obj->v.algorithm = (methodType==HTTP_HDR_GET?ALG_TYPE_CAPTCHA:ALG_TYPE_HTTP_COOKIE);
-		obj->v.count = 0;
-		ConstructResponse(methodType);
-		result = hash_table_insert(htbl, dataBuf, copy, (void*)&(obj->k), (void*)&(obj->v), param->expired);
-		if( result == RET_OCCUPY )
-		{
-			mempool_put_object(mp, obj);
-		}
+		return -1;
+	}
+	hash_trace_start(g_pstAlgTrace);
 
-		return VERIFY_BEGIN;
+	return 0;
+}
+
+int64_t AlgTraceDump(const char *path)
+{
+	int64_t written = 0;
+
+	if( !g_pstAlgTrace || !path )
+	{
+		return -1;
 	}
 
-DONE:
-	if( v && update )
+	hash_trace_stop(g_pstAlgTrace);
+	written = hash_trace_dump(g_pstAlgTrace, path);
+	if( written < 0 )
 	{
-		fUpdate.userData = (void*)v;
-		hash_table_update(htbl, dataBuf, copy, (void*)&(obj->k), &fUpdate);
+		PERR("Dump verify table trace to %s failed\n", path);
 	}
 
-	return ret;
+	return written;
 }
-
@@ -4,6 +4,8 @@
 #include <rte_jhash.h>
 #include <rte_malloc.h>
 
+#include "hashTableT.h"
+
 enum ALG_TYPE
 {
     ALG_TYPE_CAPTCHA = 0,
@@ -24,6 +26,32 @@ enum ALG_TYPE
 #define NODE_STATUS_UNTRUST 3
 
 #define ALG_HASH_TABLE_SIZE 12000000
+/*each shard is saved to ALG_SNAPSHOT_PATH.<shard index>*/
+#define ALG_SNAPSHOT_PATH "/var/run/cc_verify.snap"
+#define ALG_SNAPSHOT_PATH_MAX 256
+/*verdicts copied to the replica of each socket, see hashReplica.h*/
+#define ALG_REPLICA_SIZE (ALG_HASH_TABLE_SIZE/4)
+#define ALG_REPLICA_LOG_SIZE 65536
+#define ALG_REPLICA_SYNC_BUDGET 256
+/*a replica behind the log for longer is not read*/
+#define ALG_REPLICA_STALE_MS 100
+/*
+ * Sites are hashed by Host into ALG_TENANT_SLOTS tenants, each may hold at most its quota of
+ * nodes of the verify table, ALG_TENANT_QUOTA unless set by AlgTenantSetQuota. Sites sharing a
+ * slot share its quota.
+ */
+#define ALG_TENANT_SLOTS 4096
+#define ALG_TENANT_QUOTA (ALG_HASH_TABLE_SIZE/8)
+/*
+ * Once the mempool of an lcore has less than ALG_MEMPOOL_LOW_PERCENT of its nodes left, each get
+ * first gives back up to ALG_RECLAIM_WANT nodes of the lcore from the verify table, expired ones
+ * first, walking about ALG_RECLAIM_BUDGET slots
+ */
+#define ALG_MEMPOOL_LOW_PERCENT 2
+#define ALG_RECLAIM_WANT 16
+#define ALG_RECLAIM_BUDGET 1024
+/*records kept per lcore by the operation trace, see AlgTraceStart*/
+#define ALG_TRACE_RECORDS (1<<20)
 
 struct AlgParam
 {
@@ -34,6 +62,10 @@ struct key
 {
 	unsigned int hashKey;
 	unsigned int verifyKey;
+	/*tenant of the Host of the client, not compared by compare()*/
+	unsigned int tenant;
+	/*IPv4 address of the client in host byte order, 0 for IPv6, not compared by compare()*/
+	unsigned int ip;
 };
 
 struct value
@@ -43,6 +75,21 @@ struct value
 	unsigned int count;
 };
 
+struct AlgKeyHasher
+{
+	static unsigned int Hash(const struct key &k)
+	{
+		return k.hashKey;
+	}
+};
+
+/*
+ * per lcore verify table with the ops inlined, the key is filled by hash() beforehand. It compares
+ * all 16 bytes of the key with memcmp, tenant and ip included, as the inline strategy and the
+ * replica do, so the key must be filled the same way for every lookup of a client.
+ */
+typedef HashTableT<struct key, struct value, AlgKeyHasher> AlgVerifyTable;
+
 struct CCVerifyNode 
 {
 	struct key k;
@@ -50,14 +97,62 @@ struct CCVerifyNode
 };
 
 extern struct HashTableOps g_stAlgHtblOps;
+extern struct HashTableOps g_stAlgReplicaOps;
+extern struct hashShard *g_pstAlgShard;
+extern struct hashReplica *g_pstAlgReplica;
+extern struct hashTrace *g_pstAlgTrace;
 
 void *rte_malloc_wrap(size_t size);
+void *rte_malloc_socket_wrap(size_t size, int socket);
 void rte_free_wrap(void *addr, int len);
 void assess_node(void *data);
 void assign_key(void *src, void *dst);
 void assign_value(void *src, void *dst);
+void release_node(void *key, void *value, unsigned int owner);
+struct Mempool;
+/*low watermark callback of the mempool of an lcore, userData is the lcore id*/
+void AlgMempoolLow(struct Mempool *mp, void *userData);
 int compare(void *key1, void *key2);
 int hash(void *data, int dLen, void *key);
+unsigned int key_hash(void *key);
+uint32_t key_ip(void *key);
+/*
+ * called from the main loop of every lcore, takes back the nodes other lcores released into the
+ * mempool of the lcore, flushes the clients staged by the lcore and applies the verdicts of the
+ * other lcores to the replica
+ */
+void AlgMaintain(void);
+
+/*tenant of a Host, see ALG_TENANT_SLOTS*/
+unsigned int AlgTenantOf(const char *host, unsigned int len);
+/*set the maximum number of nodes of the tenant of host, 0 restores ALG_TENANT_QUOTA*/
+void AlgTenantSetQuota(const char *host, unsigned int len, unsigned int quota);
+/*number of nodes of the verify table held by the tenant of host*/
+unsigned int AlgTenantCount(const char *host, unsigned int len);
+
+/*
+ * Drop the verify nodes of an IPv4 client or subnet, so a banned address is verified again instead
+ * of passing on an earlier TRUST verdict. The verdicts are retracted from the replicas too.
+ * Return the number of nodes dropped or -1.
+ */
+int AlgInvalidateIp(const char *ip, unsigned int prefixLen);
+
+/*save the verify nodes of all the shards, return the number of nodes saved or -1*/
+int AlgSnapshotSave(const char *path);
+/*
+ * Restore a part of the saved nodes with objects from the mempool of lcore, which then owns the
+ * nodes. The parts may be restored by different threads at once. Return the number of nodes
+ * restored or -1.
+ */
+int AlgSnapshotLoad(const char *path, unsigned int part, unsigned int parts, unsigned int lcore);
+
+/*
+ * Record the lookups and upserts of the verify table on every lcore, to be replayed offline
+ * against other strategies by test_mempool. AlgTraceDump stops the capture and writes the last
+ * ALG_TRACE_RECORDS operations of each lcore to path. Return the number of records written or -1.
+ */
+int AlgTraceStart(void);
+int64_t AlgTraceDump(const char *path);
 
 #endif
 
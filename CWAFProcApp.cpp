@@ -1,23 +1,104 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/syscall.h>
+#include "hashShard.h"
+#include "hashReplica.h"
+#include "hashTrace.h"
+#include <rte_launch.h>
+
+/*part of the saved verify nodes restored by one owner lcore*/
+struct AlgRestorePart
+{
+	unsigned int uiPart;
+	unsigned int uiParts;
+	unsigned int uiLcore;
+	bool bLaunched;
+	int iRestored;
+};
+
+static int AlgRestoreMain(void *arg)
+{
+	struct AlgRestorePart *pstPart = (struct AlgRestorePart *)arg;
+
+	pstPart->iRestored = AlgSnapshotLoad(ALG_SNAPSHOT_PATH, pstPart->uiPart, pstPart->uiParts, pstPart->uiLcore);
+	return 0;
+}
 
 bool CWAFProcApp::InitMemStart(CConfig *pConfig)
 {
 	if (app_defend_defend != 0)
 	{
 		uint32_t uiMaxElemCount = ALG_HASH_TABLE_SIZE / app_defend_defend + 1000;
-		struct hashTable *htblAlg = hash_table_create(ALG_HASH_TABLE_SIZE, HASH_STRATEGY_SELF_EXPIRED, &g_stAlgHtblOps);
+		unsigned int auiOwner[MS_MAX_LCORE];
+		unsigned int uiOwnerCount = 0;
+
+		/*one shard per enabled lcore, placed on the socket of that lcore*/
+		for (uint32_t i = 0; i < MS_MAX_LCORE; i++)
+		{
+			if (rte_lcore_is_enabled(i))
+			{
+				auiOwner[uiOwnerCount++] = i;
+			}
+		}
+		g_pstAlgShard = hash_shard_create(ALG_HASH_TABLE_SIZE, HASH_STRATEGY_SELF_EXPIRED, &g_stAlgHtblOps, auiOwner, uiOwnerCount);
+		if (!g_pstAlgShard)
+		{
+			return false;
+		}
+		/*the verdicts are read from a copy on each socket, the sockets without lcore get none*/
+		g_pstAlgReplica = hash_replica_create(ALG_REPLICA_SIZE, &g_stAlgReplicaOps, auiOwner, uiOwnerCount, ALG_REPLICA_LOG_SIZE,
+				rte_get_tsc_hz()*ALG_REPLICA_STALE_MS/1000);
+		if (!g_pstAlgReplica)
+		{
+			return false;
+		}
+		/*the rings stay untouched until AlgTraceStart, the verify table runs without them*/
+		g_pstAlgTrace = hash_trace_create(auiOwner, uiOwnerCount, ALG_TRACE_RECORDS, rte_malloc_wrap, rte_free_wrap);
+		if (!g_pstAlgTrace)
+		{
+			PERR("Create verify table trace failed\n");
+		}
 		for (uint32_t i = 0; i < MS_MAX_LCORE; i++)
 		{
 			struct lcore_conf *lconf = &(g_serverApp.lcoreConf[i]);
 
-			lconf->htblAlg = htblAlg;
+			lconf->htblAlg = hash_shard_table(g_pstAlgShard, i);
 			lconf->mpAlg = mempool_create(sizeof(struct CCVerifyNode), uiMaxElemCount, rte_malloc_wrap, rte_free_wrap);
-			if ((!lconf->htblAlg) || (!lconf->mpAlg))
+			if (!lconf->mpAlg)
 			{
 				return false;
 			}
+			/*a dry mempool evicts the oldest clients of the lcore instead of failing the new ones*/
+			mempool_set_low_watermark(lconf->mpAlg, uiMaxElemCount*ALG_MEMPOOL_LOW_PERCENT/100, AlgMempoolLow, (void*)(uintptr_t)i);
+		}
+		/*
+		 * warm restart, the saved nodes are spread over the mempools of the owners. Each owner lcore
+		 * restores its part at once, the part of the master lcore or of a busy lcore is restored here.
+		 */
+		struct AlgRestorePart astRestore[MS_MAX_LCORE];
+		for (uint32_t i = 0; i < uiOwnerCount; i++)
+		{
+			astRestore[i].uiPart = i;
+			astRestore[i].uiParts = uiOwnerCount;
+			astRestore[i].uiLcore = auiOwner[i];
+			astRestore[i].iRestored = 0;
+			astRestore[i].bLaunched = (auiOwner[i] != rte_get_master_lcore() &&
+					rte_eal_remote_launch(AlgRestoreMain, &astRestore[i], auiOwner[i]) == 0);
+		}
+		for (uint32_t i = 0; i < uiOwnerCount; i++)
+		{
+			if (!astRestore[i].bLaunched)
+			{
+				AlgRestoreMain(&astRestore[i]);
+			}
+		}
+		rte_eal_mp_wait_lcore();
+		for (uint32_t i = 0; i < uiOwnerCount; i++)
+		{
+			if (astRestore[i].iRestored > 0)
+			{
+				PERR("Restored %d verify nodes on lcore %u\n", astRestore[i].iRestored, auiOwner[i]);
+			}
 		}
 	}
 		
@@ -0,0 +1,362 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_config.h>
+#include <rte_atomic.h>
+#include <rte_cycles.h>
+#include <rte_common.h>
+#include <rte_lcore.h>
+
+#include "hashReplica.h"
+
+#define REPLICA_OP_SET 1
+#define REPLICA_OP_DEL 2
+
+#define REPLICA_NONE -1
+/*keys removed per iteration while clearing a replica*/
+#define REPLICA_CLEAR_BATCH 64
+/*slots of the replica examined for expired nodes per sync*/
+#define REPLICA_EXPIRE_BUDGET 256
+
+struct HashReplicaEntry
+{
+	/*sequence number of the entry plus one once published, 0 while it is written*/
+	volatile uint64_t seq;
+	uint64_t timeout;
+	uint32_t op;
+	uint32_t pad;
+	/*keySize bytes of key followed by valueSize bytes of value*/
+	unsigned char data[0];
+};
+
+struct HashReplicaNode
+{
+	struct hashTable *htbl;
+	int socket;
+	/*the lcore applying the log*/
+	unsigned int syncer;
+	/*next log entry to apply*/
+	uint64_t cursor;
+	/*start of the last sync which applied every entry published before it*/
+	volatile uint64_t syncedAt;
+	/*the log overran the replica, it is cleared and the readers go to the primary meanwhile*/
+	volatile int clearing;
+	unsigned int clearCursor;
+	unsigned int batchCount;
+	/*copy of the entry being applied and keys of the nodes being cleared*/
+	unsigned char *scratch;
+	unsigned char *batch;
+};
+
+struct hashReplica
+{
+	rte_atomic64_t head;
+	unsigned int count;
+	unsigned int keySize;
+	unsigned int valueSize;
+	unsigned int entrySize;
+	uint64_t logMask;
+	uint64_t staleness;
+	fpKeyHash keyHash;
+	unsigned char *log;
+	int lcoreReplica[RTE_MAX_LCORE];
+	struct HashReplicaNode replica[0];
+};
+
+static inline struct HashReplicaEntry *ReplicaEntry(struct hashReplica *rep, uint64_t seq)
+{
+	return (struct HashReplicaEntry*)(rep->log + (seq & rep->logMask)*rep->entrySize);
+}
+
+/*the replica synced by the calling lcore, NULL if it syncs none*/
+static struct HashReplicaNode *ReplicaOfSyncer(struct hashReplica *rep)
+{
+	unsigned int lcore = rte_lcore_id();
+	int idx = REPLICA_NONE;
+
+	if( lcore < RTE_MAX_LCORE )
+	{
+		idx = rep->lcoreReplica[lcore];
+	}
+	if( idx == REPLICA_NONE || rep->replica[idx].syncer != lcore )
+	{
+		return NULL;
+	}
+	return &rep->replica[idx];
+}
+
+struct hashReplica *hash_replica_create(unsigned int capacity, struct HashTableOps *ops, const unsigned int *lcores, unsigned int count,
+		unsigned int logSize, uint64_t staleness)
+{
+	struct hashReplica *rep = NULL;
+	struct HashReplicaNode *node = NULL;
+	struct HashTableOps replicaOps;
+	unsigned int i = 0;
+	unsigned int j = 0;
+	int socket = 0;
+
+	if( !ops || !ops->keySize || !ops->valueSize || !ops->keyHashFunc || !lcores || !count || !logSize )
+	{
+		printf("keySize/valueSize/keyHashFunc and the reader lcores must be provided!\n");
+		goto FAILED;
+	}
+
+	rep = malloc(sizeof(struct hashReplica) + sizeof(struct HashReplicaNode)*count);
+	if( !rep )
+	{
+		printf("Malloc Hash Replica failed\n");
+		goto FAILED;
+	}
+	memset(rep, 0x00, sizeof(struct hashReplica) + sizeof(struct HashReplicaNode)*count);
+	rte_atomic64_init(&rep->head);
+	rep->keySize = ops->keySize;
+	rep->valueSize = ops->valueSize;
+	rep->entrySize = RTE_ALIGN_CEIL(sizeof(struct HashReplicaEntry) + ops->keySize + ops->valueSize, sizeof(uint64_t));
+	rep->logMask = rte_align32pow2(logSize) - 1;
+	rep->staleness = staleness;
+	rep->keyHash = ops->keyHashFunc;
+	for( i = 0; i < RTE_MAX_LCORE; i++)
+	{
+		rep->lcoreReplica[i] = REPLICA_NONE;
+	}
+
+	rep->log = malloc((size_t)rep->entrySize*(rep->logMask+1));
+	if( !rep->log )
+	{
+		printf("Malloc replica log failed\n");
+		goto FAILED;
+	}
+	memset(rep->log, 0x00, (size_t)rep->entrySize*(rep->logMask+1));
+
+	for( i = 0; i < count; i++)
+	{
+		socket = rte_lcore_to_socket_id(lcores[i]);
+		for( j = 0; j < rep->count && rep->replica[j].socket != socket; j++)
+		{
+		}
+		if( j == rep->count )
+		{
+			/*the replicas are read concurrently and the objects of the primary are not theirs*/
+			replicaOps = *ops;
+			replicaOps.socket = socket;
+			replicaOps.flags &= ~HASH_TABLE_F_SINGLE_OWNER;
+			replicaOps.expireFunc = NULL;
+			replicaOps.evictFunc = NULL;
+
+			node = &rep->replica[rep->count++];
+			node->socket = socket;
+			node->syncer = lcores[i];
+			node->syncedAt = rte_rdtsc();
+			node->htbl = hash_table_create(capacity, HASH_STRATEGY_INLINE, &replicaOps);
+			node->scratch = malloc(rep->entrySize);
+			node->batch = malloc((size_t)rep->keySize*REPLICA_CLEAR_BATCH);
+			if( !node->htbl || !node->scratch || !node->batch )
+			{
+				printf("Create replica on socket %d failed\n", socket);
+				goto FAILED;
+			}
+		}
+		if( lcores[i] < RTE_MAX_LCORE )
+		{
+			rep->lcoreReplica[lcores[i]] = j;
+		}
+	}
+
+	return rep;
+
+FAILED:
+	hash_replica_destroy(rep);
+	return NULL;
+}
+
+void hash_replica_destroy(struct hashReplica *rep)
+{
+	unsigned int i = 0;
+
+	if( !rep )
+	{
+		return;
+	}
+
+	for( ; i < rep->count; i++)
+	{
+		hash_table_destroy(rep->replica[i].htbl);
+		free(rep->replica[i].scratch);
+		free(rep->replica[i].batch);
+	}
+	free(rep->log);
+	free(rep);
+}
+
+/*
+ * The entry is claimed by moving head, then written with seq cleared. A reader checks seq before
+ * and after copying the entry and checks head did not move a whole log past it meanwhile, so an
+ * entry overwritten by a writer of the next lap is never applied.
+ */
+static int ReplicaLog(struct hashReplica *rep, uint32_t op, void *key, void *value, uint64_t timeout)
+{
+	struct HashReplicaEntry *e = NULL;
+	uint64_t seq = 0;
+
+	if( !rep || !key )
+	{
+		return -1;
+	}
+
+	seq = (uint64_t)rte_atomic64_add_return(&rep->head, 1) - 1;
+	e = ReplicaEntry(rep, seq);
+	e->seq = 0;
+	rte_smp_wmb();
+	e->op = op;
+	e->timeout = timeout;
+	memcpy(e->data, key, rep->keySize);
+	if( value )
+	{
+		memcpy(e->data + rep->keySize, value, rep->valueSize);
+	}
+	rte_smp_wmb();
+	e->seq = seq + 1;
+
+	return 0;
+}
+
+int hash_replica_publish(struct hashReplica *rep, void *key, void *value, uint64_t timeout)
+{
+	if( !value )
+	{
+		return -1;
+	}
+	return ReplicaLog(rep, REPLICA_OP_SET, key, value, timeout);
+}
+
+int hash_replica_retract(struct hashReplica *rep, void *key)
+{
+	return ReplicaLog(rep, REPLICA_OP_DEL, key, NULL, 0);
+}
+
+void *hash_replica_find(struct hashReplica *rep, const struct HashSig *sig, void *key, void *copy)
+{
+	struct HashReplicaNode *node = NULL;
+	unsigned int lcore = rte_lcore_id();
+
+	if( !rep || lcore >= RTE_MAX_LCORE || rep->lcoreReplica[lcore] == REPLICA_NONE )
+	{
+		return NULL;
+	}
+
+	node = &rep->replica[rep->lcoreReplica[lcore]];
+	if( node->clearing || rte_rdtsc() - node->syncedAt > rep->staleness )
+	{
+		return NULL;
+	}
+	return hash_table_find_with_sig(node->htbl, sig, key, copy, NULL);
+}
+
+static int ReplicaCollect(void *key, __rte_unused void *value, __rte_unused uint64_t expired, void *userData)
+{
+	struct hashReplica *rep = userData;
+	struct HashReplicaNode *node = ReplicaOfSyncer(rep);
+
+	memcpy(node->batch + (size_t)node->batchCount*rep->keySize, key, rep->keySize);
+	node->batchCount++;
+
+	return node->batchCount == REPLICA_CLEAR_BATCH;
+}
+
+/*delete one batch of the nodes of the replica, the visitor may not call back into the table*/
+static void ReplicaClear(struct hashReplica *rep, struct HashReplicaNode *node)
+{
+	struct HashSig sig;
+	unsigned int slots = hash_table_slots(node->htbl);
+	unsigned int i = 0;
+
+	node->batchCount = 0;
+	hash_table_iterate(node->htbl, node->clearCursor, slots, ReplicaCollect, rep, &node->clearCursor);
+	for( ; i < node->batchCount; i++)
+	{
+		sig.hash = rep->keyHash(node->batch + (size_t)i*rep->keySize);
+		hash_table_delete_with_sig(node->htbl, &sig, node->batch + (size_t)i*rep->keySize, NULL);
+	}
+	if( node->clearCursor >= slots )
+	{
+		node->clearing = 0;
+	}
+}
+
+static void ReplicaApply(struct hashReplica *rep, struct HashReplicaNode *node, struct HashReplicaEntry *e)
+{
+	struct HashSig sig;
+
+	if( e->op == REPLICA_OP_SET )
+	{
+		hash_table_insert_key(node->htbl, e->data, e->data + rep->keySize, e->timeout);
+	}
+	else
+	{
+		sig.hash = rep->keyHash(e->data);
+		hash_table_delete_with_sig(node->htbl, &sig, e->data, NULL);
+	}
+}
+
+int hash_replica_sync(struct hashReplica *rep, unsigned int budget)
+{
+	struct HashReplicaNode *node = NULL;
+	struct HashReplicaEntry *e = NULL;
+	struct HashReplicaEntry *copy = NULL;
+	uint64_t start = rte_rdtsc();
+	uint64_t head = 0;
+	uint64_t seq = 0;
+	int applied = 0;
+
+	if( !rep || !(node = ReplicaOfSyncer(rep)) )
+	{
+		return 0;
+	}
+
+	head = rte_atomic64_read(&rep->head);
+	if( head - node->cursor > rep->logMask + 1 )
+	{
+		/*entries not applied yet were overwritten, start over from an empty replica*/
+		node->clearing = 1;
+		node->clearCursor = 0;
+		node->cursor = head;
+	}
+	if( node->clearing )
+	{
+		ReplicaClear(rep, node);
+		if( node->clearing )
+		{
+			return 0;
+		}
+	}
+
+	copy = (struct HashReplicaEntry*)node->scratch;
+	for( ; budget > 0 && node->cursor != head; budget--)
+	{
+		e = ReplicaEntry(rep, node->cursor);
+		seq = e->seq;
+		if( seq != node->cursor + 1 )
+		{
+			/*still written, or already reused by a writer of the next lap*/
+			break;
+		}
+		rte_smp_rmb();
+		memcpy(copy, e, rep->entrySize);
+		rte_smp_rmb();
+		if( e->seq != seq || rte_atomic64_read(&rep->head) - node->cursor > rep->logMask + 1 )
+		{
+			break;
+		}
+		ReplicaApply(rep, node, copy);
+		node->cursor++;
+		applied++;
+	}
+	if( node->cursor == head )
+	{
+		node->syncedAt = start;
+	}
+	hash_table_expire(node->htbl, REPLICA_EXPIRE_BUDGET);
+
+	return applied;
+}
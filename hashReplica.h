@@ -0,0 +1,104 @@
+/*
+ *
+ *  NUMA-local read replicas of a hash table.
+ *
+ *  The primary table stays where it is and takes all the writes. The caller logs the writes it
+ *  wants to be seen by the readers of other sockets with hash_replica_publish/retract, and one
+ *  lcore of each socket applies the log to the replica of its socket in hash_replica_sync. The
+ *  other lcores of the socket then read the replica, which only touches memory of their node.
+ *
+ *  A replica is a HASH_STRATEGY_INLINE table allocated on its socket, key and value are copied
+ *  into it so no pointer leads back to the primary. It is a cache of the primary: a miss, a
+ *  replica which has not caught up with the log for longer than the staleness bound or one which
+ *  fell behind a whole log and is being cleared answers NULL, the caller then asks the primary.
+ *
+ */
+
+#ifndef _HASHREPLICA_H_
+#define _HASHREPLICA_H_
+
+#include <stdint.h>
+
+#include "hashTable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct hashReplica;
+
+/*
+ * @Create a replica on the socket of each given lcore
+ *
+ * @param
+ *  capacity: the maximum count number stored in each replica
+ *  ops: interface of the replicas, keySize, valueSize and keyHashFunc must be set, keyHashFunc giving
+ *   the hash of the signatures passed to hash_replica_find. socket is set by each replica
+ *  lcores: lcores reading the replicas, the first lcore of each socket applies the log
+ *  count: number of lcores
+ *  logSize: number of entries of the change log, rounded up to a power of two. A replica more
+ *   than logSize entries behind is cleared
+ *  staleness: cycles after which a replica that has not caught up with the log stops answering
+ *
+ * @return
+ *  The replicas, NULL if failed
+ */
+struct hashReplica *hash_replica_create(unsigned int capacity, struct HashTableOps *ops, const unsigned int *lcores, unsigned int count,
+		unsigned int logSize, uint64_t staleness);
+void hash_replica_destroy(struct hashReplica *rep);
+
+/*
+ * @Log a node written to the primary
+ *
+ * Any lcore may publish. The node replaces the one of the same key in every replica, once each
+ * syncing lcore went through the entry.
+ *
+ * @param
+ *  rep: replicas
+ *  key: key struct, keySize bytes are copied
+ *  value: value struct, valueSize bytes are copied
+ *  timeout: the time when the node expire
+ *
+ * @return
+ *  0: success
+ *  -1: failed
+ */
+int hash_replica_publish(struct hashReplica *rep, void *key, void *value, uint64_t timeout);
+/*log a key deleted from the primary*/
+int hash_replica_retract(struct hashReplica *rep, void *key);
+
+/*
+ * @Search the replica of the socket of the calling lcore
+ *
+ * @param
+ *  rep: replicas
+ *  sig: hash value of the key, see hash_table_sig
+ *  key: key filled by hash_table_sig
+ *  copy: a copy of the value of the node and the time when the node expire, see hash_table_find
+ *
+ * @return
+ *  NULL: not find, the replica is too stale or the lcore has no replica. Ask the primary
+ *  Not NULL: the node was found, only copy may be read
+ */
+void *hash_replica_find(struct hashReplica *rep, const struct HashSig *sig, void *key, void *copy);
+
+/*
+ * @Apply the log to the replica of the calling lcore
+ *
+ * Every lcore given to hash_replica_create calls it from its main loop, it returns at once on the
+ * lcores not syncing a replica. The syncing lcore also expires the nodes of its replica.
+ *
+ * @param
+ *  rep: replicas
+ *  budget: about the maximum number of log entries applied
+ *
+ * @return
+ *  the number of log entries applied
+ */
+int hash_replica_sync(struct hashReplica *rep, unsigned int budget);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
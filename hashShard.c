@@ -0,0 +1,391 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_config.h>
+#include <rte_common.h>
+#include <rte_lcore.h>
+
+#include "hashShard.h"
+
+/*odd constant spreading all the bits of the hash over the high bits used to select a shard*/
+#define SHARD_HASH_MUL 0x9E3779B1u
+
+struct HashShardEntry
+{
+	struct hashTable *htbl;
+	unsigned int lcore;
+};
+
+struct hashShard
+{
+	unsigned int count;
+	unsigned int flags;
+	fpHash hash;
+	fpKeyHash keyHash;
+	/*shard hash_shard_reclaim starts from*/
+	volatile unsigned int reclaimNext;
+	struct HashShardEntry shard[0];
+};
+
+/*
+ * The sub-tables index their buckets with the low bits of the hash, the shard is chosen from
+ * the high bits of a multiplication so both choices stay independent.
+ */
+static inline struct HashShardEntry *ShardOfHash(struct hashShard *shard, unsigned int hash)
+{
+	return &shard->shard[((uint64_t)(hash*SHARD_HASH_MUL)*shard->count) >> 32];
+}
+
+static inline struct HashShardEntry *ShardOf(struct hashShard *shard, void *data, int dLen, void *key)
+{
+	return ShardOfHash(shard, (unsigned int)shard->hash(data, dLen, key));
+}
+
+struct hashShard *hash_shard_create(unsigned int capacity, enum HASH_STRATEGY mode, struct HashTableOps *ops, const unsigned int *lcores, unsigned int count)
+{
+	struct hashShard *shard = NULL;
+	struct HashTableOps shardOps;
+	unsigned int i = 0;
+
+	if( !ops || !ops->hash || !lcores || !count )
+	{
+		printf("hash interface and owner lcores must be provided!\n");
+		goto FAILED;
+	}
+
+	shard = malloc(sizeof(struct hashShard) + sizeof(struct HashShardEntry)*count);
+	if( !shard )
+	{
+		printf("Malloc Hash Shard failed\n");
+		goto FAILED;
+	}
+	memset(shard, 0x00, sizeof(struct hashShard) + sizeof(struct HashShardEntry)*count);
+	shard->count = count;
+	shard->flags = ops->flags;
+	shard->hash = ops->hash;
+	shard->keyHash = ops->keyHashFunc;
+
+	for( ; i < count; i++)
+	{
+		shardOps = *ops;
+		shardOps.socket = rte_lcore_to_socket_id(lcores[i]);
+		shard->shard[i].lcore = lcores[i];
+		shard->shard[i].htbl = hash_table_create((capacity + count - 1)/count, mode, &shardOps);
+		if( !shard->shard[i].htbl )
+		{
+			printf("Create shard %u on socket %d failed\n", i, shardOps.socket);
+			goto FAILED;
+		}
+	}
+
+	return shard;
+
+FAILED:
+	hash_shard_destroy(shard);
+	return NULL;
+}
+
+void hash_shard_destroy(struct hashShard *shard)
+{
+	unsigned int i = 0;
+
+	if( !shard )
+	{
+		return;
+	}
+
+	for( ; i < shard->count; i++)
+	{
+		hash_table_destroy(shard->shard[i].htbl);
+	}
+	free(shard);
+}
+
+unsigned int hash_shard_owner(struct hashShard *shard, void *data, int dLen, void *key)
+{
+	return ShardOf(shard, data, dLen, key)->lcore;
+}
+
+struct hashTable *hash_shard_table(struct hashShard *shard, unsigned int lcore)
+{
+	unsigned int i = 0;
+
+	for( ; i < shard->count; i++)
+	{
+		if( shard->shard[i].lcore == lcore )
+		{
+			return shard->shard[i].htbl;
+		}
+	}
+
+	return NULL;
+}
+
+struct hashTable *hash_shard_at(struct hashShard *shard, unsigned int index)
+{
+	if( !shard || index >= shard->count )
+	{
+		return NULL;
+	}
+	return shard->shard[index].htbl;
+}
+
+int hash_shard_insert_key(struct hashShard *shard, void *key, void *value, uint64_t timeout)
+{
+	if( !shard || !key || !shard->keyHash )
+	{
+		return RET_FAILED;
+	}
+
+	return hash_table_insert_key(ShardOfHash(shard, shard->keyHash(key))->htbl, key, value, timeout);
+}
+
+int hash_shard_sig(struct hashShard *shard, void *data, int dLen, void *key, struct HashSig *sig)
+{
+	if( !shard || !key || !dLen || !sig )
+	{
+		return -1;
+	}
+
+	sig->hash = (unsigned int)shard->hash(data, dLen, key);
+	return 0;
+}
+
+unsigned int hash_shard_owner_with_sig(struct hashShard *shard, const struct HashSig *sig)
+{
+	return ShardOfHash(shard, sig->hash)->lcore;
+}
+
+/*the data is hashed once to route the key, the sub-table is given the signature*/
+int hash_shard_insert(struct hashShard *shard, void *data, int dLen, void *key, void *value, uint64_t timeout)
+{
+	struct HashSig sig;
+
+	if( hash_shard_sig(shard, data, dLen, key, &sig) < 0 )
+	{
+		return RET_FAILED;
+	}
+
+	return hash_shard_insert_with_sig(shard, &sig, key, value, timeout);
+}
+
+void *hash_shard_find(struct hashShard *shard, void *data, int dLen, void *key, void *copy, struct UpdateCallBack *callback)
+{
+	struct HashSig sig;
+
+	if( hash_shard_sig(shard, data, dLen, key, &sig) < 0 )
+	{
+		return NULL;
+	}
+
+	return hash_shard_find_with_sig(shard, &sig, key, copy, callback);
+}
+
+int hash_shard_update(struct hashShard *shard, void *data, int dLen, void *key, struct UpdateCallBack *callback)
+{
+	struct HashSig sig;
+
+	if( hash_shard_sig(shard, data, dLen, key, &sig) < 0 )
+	{
+		return -1;
+	}
+
+	return hash_shard_update_with_sig(shard, &sig, key, callback);
+}
+
+int hash_shard_upsert(struct hashShard *shard, void *data, int dLen, void *key, void *value, uint64_t timeout,
+		struct UpsertCallBack *callback, struct HashNodeCopy *copy)
+{
+	struct HashSig sig;
+
+	if( hash_shard_sig(shard, data, dLen, key, &sig) < 0 )
+	{
+		return RET_FAILED;
+	}
+
+	return hash_shard_upsert_with_sig(shard, &sig, key, value, timeout, callback, copy);
+}
+
+int hash_shard_delete(struct hashShard *shard, void *data, int dLen, void *key, void *copy)
+{
+	struct HashSig sig;
+
+	if( hash_shard_sig(shard, data, dLen, key, &sig) < 0 )
+	{
+		return RET_FAILED;
+	}
+
+	return hash_shard_delete_with_sig(shard, &sig, key, copy);
+}
+
+void hash_shard_prefetch_sig(struct hashShard *shard, const struct HashSig *sig)
+{
+	if( shard && sig )
+	{
+		hash_table_prefetch_sig(ShardOfHash(shard, sig->hash)->htbl, sig);
+	}
+}
+
+void *hash_shard_find_with_sig(struct hashShard *shard, const struct HashSig *sig, void *key, void *copy, struct UpdateCallBack *callback)
+{
+	if( !shard || !sig )
+	{
+		return NULL;
+	}
+
+	return hash_table_find_with_sig(ShardOfHash(shard, sig->hash)->htbl, sig, key, copy, callback);
+}
+
+int hash_shard_insert_with_sig(struct hashShard *shard, const struct HashSig *sig, void *key, void *value, uint64_t timeout)
+{
+	if( !shard || !sig )
+	{
+		return RET_FAILED;
+	}
+
+	return hash_table_insert_with_sig(ShardOfHash(shard, sig->hash)->htbl, sig, key, value, timeout);
+}
+
+int hash_shard_update_with_sig(struct hashShard *shard, const struct HashSig *sig, void *key, struct UpdateCallBack *callback)
+{
+	if( !shard || !sig )
+	{
+		return -1;
+	}
+
+	return hash_table_update_with_sig(ShardOfHash(shard, sig->hash)->htbl, sig, key, callback);
+}
+
+int hash_shard_upsert_with_sig(struct hashShard *shard, const struct HashSig *sig, void *key, void *value, uint64_t timeout,
+		struct UpsertCallBack *callback, struct HashNodeCopy *copy)
+{
+	if( !shard || !sig )
+	{
+		return RET_FAILED;
+	}
+
+	return hash_table_upsert_with_sig(ShardOfHash(shard, sig->hash)->htbl, sig, key, value, timeout, callback, copy);
+}
+
+int hash_shard_delete_with_sig(struct hashShard *shard, const struct HashSig *sig, void *key, void *copy)
+{
+	if( !shard || !sig )
+	{
+		return RET_FAILED;
+	}
+
+	return hash_table_delete_with_sig(ShardOfHash(shard, sig->hash)->htbl, sig, key, copy);
+}
+
+void hash_shard_maintain(struct hashShard *shard)
+{
+	unsigned int lcore = rte_lcore_id();
+	unsigned int i = 0;
+
+	for( ; i < shard->count; i++)
+	{
+		if( (shard->flags & HASH_TABLE_F_SINGLE_OWNER) && shard->shard[i].lcore != lcore )
+		{
+			continue;
+		}
+		hash_table_maintain(shard->shard[i].htbl);
+	}
+}
+
+void hash_shard_flush(struct hashShard *shard)
+{
+	unsigned int i = 0;
+
+	for( ; i < shard->count; i++)
+	{
+		hash_table_flush(shard->shard[i].htbl);
+	}
+}
+
+int hash_shard_expire(struct hashShard *shard, unsigned int budget)
+{
+	unsigned int lcore = rte_lcore_id();
+	unsigned int i = 0;
+	int reclaimed = 0;
+
+	for( ; i < shard->count; i++)
+	{
+		if( shard->shard[i].lcore == lcore )
+		{
+			reclaimed += hash_table_expire(shard->shard[i].htbl, budget);
+		}
+	}
+
+	return reclaimed;
+}
+
+int hash_shard_reclaim(struct hashShard *shard, unsigned int owner, unsigned int want, unsigned int budget)
+{
+	struct HashShardEntry *entry = NULL;
+	unsigned int lcore = rte_lcore_id();
+	unsigned int step = 0;
+	unsigned int i = 0;
+	int reclaimed = 0;
+
+	if( !shard )
+	{
+		return 0;
+	}
+
+	/*each shard gets its part of the budget, so a call never walks more than budget slots*/
+	step = RTE_MAX(budget/shard->count, 1U);
+	for( ; i < shard->count && budget > 0 && reclaimed < (int)want; i++)
+	{
+		entry = &shard->shard[(shard->reclaimNext + i)%shard->count];
+		if( (shard->flags & HASH_TABLE_F_SINGLE_OWNER) && entry->lcore != lcore )
+		{
+			continue;
+		}
+		reclaimed += hash_table_reclaim(entry->htbl, owner, want - reclaimed, RTE_MIN(step, budget));
+		budget -= RTE_MIN(step, budget);
+	}
+	shard->reclaimNext = (shard->reclaimNext + i)%shard->count;
+
+	return reclaimed;
+}
+
+int hash_shard_invalidate_by_ip(struct hashShard *shard, uint32_t ip, unsigned int prefixLen)
+{
+	unsigned int lcore = rte_lcore_id();
+	unsigned int i = 0;
+	int deleted = 0;
+	int ret = 0;
+
+	if( !shard )
+	{
+		return -1;
+	}
+
+	for( ; i < shard->count; i++)
+	{
+		if( (shard->flags & HASH_TABLE_F_SINGLE_OWNER) && shard->shard[i].lcore != lcore )
+		{
+			continue;
+		}
+		ret = hash_table_invalidate_by_ip(shard->shard[i].htbl, ip, prefixLen);
+		if( ret < 0 )
+		{
+			return -1;
+		}
+		deleted += ret;
+	}
+
+	return deleted;
+}
+
+void hash_shard_assess(struct hashShard *shard)
+{
+	unsigned int i = 0;
+
+	for( ; i < shard->count; i++)
+	{
+		printf("Shard %u owned by lcore %u:\n", i, shard->shard[i].lcore);
+		hash_table_assess(shard->shard[i].htbl);
+	}
+}
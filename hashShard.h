@@ -0,0 +1,155 @@
+/*
+ *
+ *  Sharded hash table front-end.
+ *
+ *  The key space is split over independent sub-tables, one per owner lcore. Each sub-table is
+ *  allocated on the NUMA node of its owner when HashTableOps mallocSocketFunc is provided, so the
+ *  bucket locks taken by an insert stay on one socket instead of bouncing over the whole machine.
+ *
+ *  By default any lcore may access any shard, the sub-tables take their usual locks. With
+ *  HASH_TABLE_F_SINGLE_OWNER set in ops->flags the sub-tables take no lock at all and a key may
+ *  only be accessed by the lcore returned by hash_shard_owner, the caller steers its traffic or
+ *  forwards the operation to that lcore.
+ *
+ */
+
+#ifndef _HASHSHARD_H_
+#define _HASHSHARD_H_
+
+#include <stdint.h>
+
+#include "hashTable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct hashShard;
+
+/*
+ * @Create a sharded hash table
+ *
+ * @param
+ *  capacity: the maximum count number stored in all the shards
+ *  mode: expiration-strategy of the sub-tables
+ *  ops: user-defined interface of the sub-tables, socket is set by each shard
+ *  lcores: owner lcore of each shard, the sub-table is placed on the socket of its owner
+ *  count: number of shards
+ *
+ * @return
+ *  The sharded hash table, NULL if any sub-table can not be created
+ */
+struct hashShard *hash_shard_create(unsigned int capacity, enum HASH_STRATEGY mode, struct HashTableOps *ops, const unsigned int *lcores, unsigned int count);
+void hash_shard_destroy(struct hashShard *shard);
+
+/*
+ * @Find the owner lcore of a key
+ *
+ * @param
+ *  shard: sharded hash table
+ *  data: the data used for calculating hash value
+ *  dLen: data length
+ *  key: calculate the hash info of data and stored in key struct
+ *
+ * @return
+ *  the lcore id owning the shard of the key
+ */
+unsigned int hash_shard_owner(struct hashShard *shard, void *data, int dLen, void *key);
+
+/*
+ * @Sub-table owned by an lcore
+ *
+ * @return
+ *  the first shard owned by lcore, NULL if it owns none
+ */
+struct hashTable *hash_shard_table(struct hashShard *shard, unsigned int lcore);
+
+/*
+ * @Sub-table by index
+ *
+ * @return
+ *  the sub-table of shard index, NULL past the last shard
+ */
+struct hashTable *hash_shard_at(struct hashShard *shard, unsigned int index);
+
+/*same as the hash_table_* functions, on the shard of the key*/
+int hash_shard_insert_key(struct hashShard *shard, void *key, void *value, uint64_t timeout);
+int hash_shard_insert(struct hashShard *shard, void *data, int dLen, void *key, void *value, uint64_t timeout);
+void *hash_shard_find(struct hashShard *shard, void *data, int dLen, void *key, void *copy, struct UpdateCallBack *callback);
+int hash_shard_update(struct hashShard *shard, void *data, int dLen, void *key, struct UpdateCallBack *callback);
+int hash_shard_delete(struct hashShard *shard, void *data, int dLen, void *key, void *copy);
+int hash_shard_upsert(struct hashShard *shard, void *data, int dLen, void *key, void *value, uint64_t timeout,
+		struct UpsertCallBack *callback, struct HashNodeCopy *copy);
+
+/*
+ * @Hash data once for the _with_sig functions, see hash_table_sig
+ *
+ * The functions without _with_sig hash the data once as well, the signature lets the caller
+ * compute it early and reuse it over several calls.
+ */
+int hash_shard_sig(struct hashShard *shard, void *data, int dLen, void *key, struct HashSig *sig);
+unsigned int hash_shard_owner_with_sig(struct hashShard *shard, const struct HashSig *sig);
+void hash_shard_prefetch_sig(struct hashShard *shard, const struct HashSig *sig);
+void *hash_shard_find_with_sig(struct hashShard *shard, const struct HashSig *sig, void *key, void *copy, struct UpdateCallBack *callback);
+int hash_shard_insert_with_sig(struct hashShard *shard, const struct HashSig *sig, void *key, void *value, uint64_t timeout);
+int hash_shard_update_with_sig(struct hashShard *shard, const struct HashSig *sig, void *key, struct UpdateCallBack *callback);
+int hash_shard_upsert_with_sig(struct hashShard *shard, const struct HashSig *sig, void *key, void *value, uint64_t timeout,
+		struct UpsertCallBack *callback, struct HashNodeCopy *copy);
+int hash_shard_delete_with_sig(struct hashShard *shard, const struct HashSig *sig, void *key, void *copy);
+
+/*
+ * @Periodic maintenance of the shards
+ *
+ * Every lcore accessing the shards must call it, see hash_table_maintain. With
+ * HASH_TABLE_F_SINGLE_OWNER only the shards owned by the calling lcore are maintained.
+ */
+void hash_shard_maintain(struct hashShard *shard);
+/*write the nodes staged by the calling lcore to every shard, see hash_table_flush*/
+void hash_shard_flush(struct hashShard *shard);
+
+/*
+ * @Reclaim expired nodes of the shards owned by the calling lcore
+ *
+ * @param
+ *  shard: sharded hash table
+ *  budget: about the maximum number of slots examined in each owned shard
+ *
+ * @return
+ *  the number of nodes reclaimed
+ */
+int hash_shard_expire(struct hashShard *shard, unsigned int budget);
+
+/*
+ * @Give back the objects of an owner from the shards, see hash_table_reclaim
+ *
+ * The shards are visited in turn from where the previous call stopped. With
+ * HASH_TABLE_F_SINGLE_OWNER only the shards owned by the calling lcore are visited.
+ *
+ * @param
+ *  shard: sharded hash table
+ *  owner: lcore whose objects are wanted, LCORE_ID_ANY for the nodes of any owner
+ *  want: number of nodes of owner after which it stops
+ *  budget: about the maximum number of slots examined over all the shards visited
+ *
+ * @return
+ *  the number of nodes of owner given back
+ */
+int hash_shard_reclaim(struct hashShard *shard, unsigned int owner, unsigned int want, unsigned int budget);
+
+/*
+ * @Delete the nodes of a client address or of a subnet from the shards, see hash_table_invalidate_by_ip
+ *
+ * With HASH_TABLE_F_SINGLE_OWNER only the shards owned by the calling lcore are visited, every
+ * owner has to call it.
+ *
+ * @return
+ *  the number of nodes deleted, -1 if the shards have no index or prefixLen is out of range
+ */
+int hash_shard_invalidate_by_ip(struct hashShard *shard, uint32_t ip, unsigned int prefixLen);
+void hash_shard_assess(struct hashShard *shard);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,446 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rte_config.h>
+#include <rte_cycles.h>
+
+#include "hashSnapshot.h"
+
+#define SNAPSHOT_MAGIC 0x4E535448
+#define SNAPSHOT_VERSION 1
+/*records copied under the slot locks before they are written out*/
+#define SNAPSHOT_BATCH 256
+#define SNAPSHOT_PATH_MAX 256
+#define US_PER_S 1000000ULL
+
+struct HashSnapshotHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t keySize;
+	uint32_t valueSize;
+	uint64_t count;
+	/*wall time the snapshot was started at, in microseconds since the Epoch*/
+	uint64_t wallTime;
+};
+
+struct HashSnapshot
+{
+	FILE *fp;
+	struct hashTable *htbl;
+	char path[SNAPSHOT_PATH_MAX];
+	char tmp[SNAPSHOT_PATH_MAX];
+	unsigned int keySize;
+	unsigned int valueSize;
+	unsigned int recSize;
+	int writing;
+	int error;
+	int done;
+
+	/*slot to save next*/
+	unsigned int cursor;
+	uint64_t count;
+	/*records left in the part being read*/
+	uint64_t remaining;
+
+	/*the same instant as TSC and as wall time, to convert the expiry times*/
+	uint64_t baseTsc;
+	uint64_t baseWall;
+	uint64_t hz;
+
+	unsigned int batchCount;
+	unsigned char *batch;
+};
+
+static uint64_t SnapshotWallTime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (uint64_t)ts.tv_sec*US_PER_S + ts.tv_nsec/1000;
+}
+
+static void SnapshotBase(struct HashSnapshot *snap)
+{
+	snap->hz = rte_get_tsc_hz();
+	snap->baseTsc = rte_rdtsc();
+	snap->baseWall = SnapshotWallTime();
+}
+
+static uint64_t SnapshotToWall(struct HashSnapshot *snap, uint64_t tsc)
+{
+	uint64_t delta = 0;
+
+	if( tsc <= snap->baseTsc )
+	{
+		return snap->baseWall;
+	}
+	delta = tsc - snap->baseTsc;
+	return snap->baseWall + delta/snap->hz*US_PER_S + delta%snap->hz*US_PER_S/snap->hz;
+}
+
+/*0 if the wall time is already past*/
+static uint64_t SnapshotToTsc(struct HashSnapshot *snap, uint64_t wall)
+{
+	uint64_t delta = 0;
+
+	if( wall <= snap->baseWall )
+	{
+		return 0;
+	}
+	delta = wall - snap->baseWall;
+	if( delta/US_PER_S >= (UINT64_MAX - snap->baseTsc)/snap->hz )
+	{
+		return UINT64_MAX;
+	}
+	return snap->baseTsc + delta/US_PER_S*snap->hz + delta%US_PER_S*snap->hz/US_PER_S;
+}
+
+static struct HashSnapshot *SnapshotAlloc(const char *path, unsigned int keySize, unsigned int valueSize)
+{
+	struct HashSnapshot *snap = NULL;
+
+	if( !path || strlen(path) + sizeof(".tmp") > SNAPSHOT_PATH_MAX || !keySize || !valueSize )
+	{
+		printf("Invalid snapshot path or key/value size!\n");
+		return NULL;
+	}
+
+	snap = malloc(sizeof(struct HashSnapshot));
+	if( !snap )
+	{
+		printf("Malloc snapshot failed.\n");
+		return NULL;
+	}
+	memset(snap, 0x00, sizeof(struct HashSnapshot));
+	snap->keySize = keySize;
+	snap->valueSize = valueSize;
+	snap->recSize = sizeof(uint64_t) + keySize + valueSize;
+	snprintf(snap->path, sizeof(snap->path), "%s", path);
+	snprintf(snap->tmp, sizeof(snap->tmp), "%s.tmp", path);
+	snap->batch = malloc(snap->recSize*SNAPSHOT_BATCH);
+	if( !snap->batch )
+	{
+		printf("Malloc snapshot batch failed.\n");
+		free(snap);
+		return NULL;
+	}
+
+	return snap;
+}
+
+static void SnapshotFree(struct HashSnapshot *snap)
+{
+	if( snap->fp )
+	{
+		fclose(snap->fp);
+	}
+	free(snap->batch);
+	free(snap);
+}
+
+static int SnapshotWriteHeader(struct HashSnapshot *snap)
+{
+	struct HashSnapshotHeader hdr;
+
+	memset(&hdr, 0x00, sizeof(hdr));
+	hdr.magic = SNAPSHOT_MAGIC;
+	hdr.version = SNAPSHOT_VERSION;
+	hdr.keySize = snap->keySize;
+	hdr.valueSize = snap->valueSize;
+	hdr.count = snap->count;
+	hdr.wallTime = snap->baseWall;
+
+	if( fseek(snap->fp, 0, SEEK_SET) < 0 || fwrite(&hdr, sizeof(hdr), 1, snap->fp) != 1 )
+	{
+		return -1;
+	}
+	return 0;
+}
+
+struct HashSnapshot *hash_snapshot_open(struct hashTable *htbl, const char *path, unsigned int keySize, unsigned int valueSize)
+{
+	struct HashSnapshot *snap = NULL;
+
+	if( !htbl )
+	{
+		return NULL;
+	}
+	snap = SnapshotAlloc(path, keySize, valueSize);
+	if( !snap )
+	{
+		return NULL;
+	}
+	snap->htbl = htbl;
+	snap->writing = 1;
+	SnapshotBase(snap);
+
+	snap->fp = fopen(snap->tmp, "wb");
+	if( !snap->fp )
+	{
+		printf("Open snapshot %s failed.\n", snap->tmp);
+		goto FAILED;
+	}
+	if( SnapshotWriteHeader(snap) < 0 )
+	{
+		printf("Write snapshot header failed.\n");
+		goto FAILED;
+	}
+
+	return snap;
+
+FAILED:
+	if( snap->fp )
+	{
+		unlink(snap->tmp);
+	}
+	SnapshotFree(snap);
+	return NULL;
+}
+
+/*copy the node into the batch, the iteration stops when the batch is full*/
+static int SnapshotVisit(void *key, void *value, uint64_t expired, void *userData)
+{
+	struct HashSnapshot *snap = (struct HashSnapshot*)userData;
+	unsigned char *rec = snap->batch + snap->batchCount*snap->recSize;
+	uint64_t wall = SnapshotToWall(snap, expired);
+
+	memcpy(rec, &wall, sizeof(wall));
+	memcpy(rec + sizeof(wall), key, snap->keySize);
+	memcpy(rec + sizeof(wall) + snap->keySize, value, snap->valueSize);
+	snap->batchCount++;
+
+	return snap->batchCount == SNAPSHOT_BATCH;
+}
+
+int hash_snapshot_step(struct HashSnapshot *snap, unsigned int budget)
+{
+	unsigned int slots = 0;
+	unsigned int end = 0;
+	unsigned int next = 0;
+
+	if( !snap || !snap->writing || snap->error )
+	{
+		return -1;
+	}
+	if( snap->done )
+	{
+		return 1;
+	}
+
+	slots = hash_table_slots(snap->htbl);
+	end = (slots - snap->cursor > budget) ? snap->cursor + budget : slots;
+	while( snap->cursor < end )
+	{
+		snap->batchCount = 0;
+		if( hash_table_iterate(snap->htbl, snap->cursor, end, SnapshotVisit, snap, &next) < 0 )
+		{
+			snap->error = 1;
+			return -1;
+		}
+		if( snap->batchCount && fwrite(snap->batch, snap->recSize, snap->batchCount, snap->fp) != snap->batchCount )
+		{
+			printf("Write snapshot %s failed.\n", snap->tmp);
+			snap->error = 1;
+			return -1;
+		}
+		snap->count += snap->batchCount;
+		snap->cursor = next;
+	}
+	if( snap->cursor >= slots )
+	{
+		snap->done = 1;
+	}
+
+	return snap->done;
+}
+
+int64_t hash_snapshot_close(struct HashSnapshot *snap)
+{
+	int64_t count = -1;
+
+	if( !snap )
+	{
+		return -1;
+	}
+	if( !snap->writing )
+	{
+		count = snap->count;
+		SnapshotFree(snap);
+		return count;
+	}
+
+	if( snap->done && !snap->error && SnapshotWriteHeader(snap) == 0 &&
+			fflush(snap->fp) == 0 && fsync(fileno(snap->fp)) == 0 )
+	{
+		fclose(snap->fp);
+		snap->fp = NULL;
+		if( rename(snap->tmp, snap->path) == 0 )
+		{
+			count = snap->count;
+		}
+	}
+	if( count < 0 )
+	{
+		printf("Snapshot %s failed.\n", snap->path);
+		unlink(snap->tmp);
+	}
+	SnapshotFree(snap);
+
+	return count;
+}
+
+int64_t hash_table_snapshot(struct hashTable *htbl, const char *path, unsigned int keySize, unsigned int valueSize)
+{
+	struct HashSnapshot *snap = NULL;
+
+	snap = hash_snapshot_open(htbl, path, keySize, valueSize);
+	if( !snap )
+	{
+		return -1;
+	}
+	while( hash_snapshot_step(snap, hash_table_slots(htbl)) == 0 );
+
+	return hash_snapshot_close(snap);
+}
+
+struct HashSnapshot *hash_snapshot_load(const char *path, unsigned int part, unsigned int parts, unsigned int keySize, unsigned int valueSize)
+{
+	struct HashSnapshot *snap = NULL;
+	struct HashSnapshotHeader hdr;
+	uint64_t first = 0;
+	uint64_t last = 0;
+
+	if( !parts || part >= parts )
+	{
+		return NULL;
+	}
+	snap = SnapshotAlloc(path, keySize, valueSize);
+	if( !snap )
+	{
+		return NULL;
+	}
+	SnapshotBase(snap);
+
+	snap->fp = fopen(snap->path, "rb");
+	if( !snap->fp )
+	{
+		goto FAILED;
+	}
+	if( fread(&hdr, sizeof(hdr), 1, snap->fp) != 1 || hdr.magic != SNAPSHOT_MAGIC ||
+			hdr.version != SNAPSHOT_VERSION || hdr.keySize != keySize || hdr.valueSize != valueSize )
+	{
+		printf("Snapshot %s does not match.\n", snap->path);
+		goto FAILED;
+	}
+
+	first = hdr.count*part/parts;
+	last = hdr.count*(part+1)/parts;
+	if( fseek(snap->fp, sizeof(hdr) + first*snap->recSize, SEEK_SET) < 0 )
+	{
+		goto FAILED;
+	}
+	snap->remaining = last - first;
+
+	return snap;
+
+FAILED:
+	SnapshotFree(snap);
+	return NULL;
+}
+
+int hash_snapshot_next(struct HashSnapshot *snap, void *key, void *value, uint64_t *expired)
+{
+	uint64_t wall = 0;
+	uint64_t tsc = 0;
+
+	if( !snap || snap->writing )
+	{
+		return -1;
+	}
+
+	while( snap->remaining > 0 )
+	{
+		snap->remaining--;
+		if( fread(snap->batch, snap->recSize, 1, snap->fp) != 1 )
+		{
+			printf("Read snapshot %s failed.\n", snap->path);
+			return -1;
+		}
+		memcpy(&wall, snap->batch, sizeof(wall));
+		tsc = SnapshotToTsc(snap, wall);
+		if( !tsc )
+		{
+			continue;
+		}
+		memcpy(key, snap->batch + sizeof(wall), snap->keySize);
+		memcpy(value, snap->batch + sizeof(wall) + snap->keySize, snap->valueSize);
+		*expired = tsc;
+		snap->count++;
+		return 1;
+	}
+
+	return 0;
+}
+
+int64_t hash_table_restore(struct hashTable *htbl, const char *path, unsigned int part, unsigned int parts,
+		unsigned int keySize, unsigned int valueSize, fpRestoreNode restore, fpExpireNode release, void *userData)
+{
+	struct HashSnapshot *snap = NULL;
+	void *key = NULL;
+	void *value = NULL;
+	void *nodeKey = NULL;
+	void *nodeValue = NULL;
+	uint64_t expired = 0;
+	int64_t restored = 0;
+	int ret = 0;
+
+	if( !htbl )
+	{
+		return -1;
+	}
+	snap = hash_snapshot_load(path, part, parts, keySize, valueSize);
+	if( !snap )
+	{
+		return -1;
+	}
+	key = malloc(keySize);
+	value = malloc(valueSize);
+	if( !key || !value )
+	{
+		restored = -1;
+		goto DONE;
+	}
+
+	while( (ret = hash_snapshot_next(snap, key, value, &expired)) > 0 )
+	{
+		nodeKey = key;
+		nodeValue = value;
+		if( restore && restore(key, value, &nodeKey, &nodeValue, userData) < 0 )
+		{
+			break;
+		}
+		ret = hash_table_insert_key(htbl, nodeKey, nodeValue, expired);
+		if( ret != RET_FAILED )
+		{
+			restored++;
+		}
+		if( ret != RET_NEW && restore && release )
+		{
+			release(nodeKey, nodeValue);
+		}
+	}
+	if( ret < 0 )
+	{
+		restored = -1;
+	}
+
+DONE:
+	free(key);
+	free(value);
+	hash_snapshot_close(snap);
+	return restored;
+}
@@ -0,0 +1,142 @@
+/*
+ *
+ *  Snapshot and warm restart of a hash table.
+ *
+ *  A snapshot streams the live nodes of a table to a file so a restarted process gets its
+ *  verified clients back instead of challenging all of them again. The expiry time of each node
+ *  is stored as wall clock time, it is converted back to the TSC of the restoring process.
+ *
+ *  The file is a header followed by fixed size records, the expiry time in microseconds since
+ *  the Epoch, keySize bytes of key and valueSize bytes of value. Fixed size records let several
+ *  lcores restore disjoint parts of the same file at once.
+ *
+ *  A snapshot is taken a few thousand slots at a time with hash_snapshot_step, lookups and
+ *  inserts go on meanwhile. Nodes are copied under the slot read lock and written to the file
+ *  outside of it. The file is written under a temporary name and renamed when complete.
+ *
+ *  HASH_STRATEGY_LRU tables store access times instead of expiry times and are not supported.
+ *
+ */
+
+#ifndef _HASHSNAPSHOT_H_
+#define _HASHSNAPSHOT_H_
+
+#include <stdint.h>
+
+#include "hashTable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Give the key/value objects a restored record is inserted with. key and value point to the
+ * record, the callback copies them into objects owned by the table, e.g. from a mempool.
+ * Return -1 to stop the restore.
+ */
+typedef int (*fpRestoreNode)(void *key, void *value, void **nodeKey, void **nodeValue, void *userData);
+
+struct HashSnapshot;
+
+/*
+ * @Start a snapshot of a hash table
+ *
+ * @param
+ *  htbl: hash table to be saved
+ *  path: file written, path.tmp is used until hash_snapshot_close
+ *  keySize: size of the key struct
+ *  valueSize: size of the value struct
+ *
+ * @return
+ *  The snapshot in progress, NULL if failed
+ */
+struct HashSnapshot *hash_snapshot_open(struct hashTable *htbl, const char *path, unsigned int keySize, unsigned int valueSize);
+
+/*
+ * @Save the next slots of the table
+ *
+ * @param
+ *  snap: snapshot in progress
+ *  budget: about the maximum number of slots examined
+ *
+ * @return
+ *  1: all the slots are saved
+ *  0: call it again
+ *  -1: write failed
+ */
+int hash_snapshot_step(struct HashSnapshot *snap, unsigned int budget);
+
+/*
+ * @Finish a snapshot
+ *
+ * The file is renamed to its final path only if every slot was saved without error, otherwise
+ * the temporary file is removed and the previous snapshot is left untouched.
+ *
+ * @return
+ *  the number of nodes saved, -1 if failed
+ */
+int64_t hash_snapshot_close(struct HashSnapshot *snap);
+
+/*save the whole table at once*/
+int64_t hash_table_snapshot(struct hashTable *htbl, const char *path, unsigned int keySize, unsigned int valueSize);
+
+/*
+ * @Open a part of a snapshot for reading
+ *
+ * The records are split into parts equal parts, each one can be read by another lcore.
+ *
+ * @param
+ *  path: snapshot file
+ *  part: the part read, from 0 to parts-1
+ *  parts: number of parts
+ *  keySize: size of the key struct, must match the file
+ *  valueSize: size of the value struct, must match the file
+ *
+ * @return
+ *  The snapshot to read, NULL if the file is missing or does not match
+ */
+struct HashSnapshot *hash_snapshot_load(const char *path, unsigned int part, unsigned int parts, unsigned int keySize, unsigned int valueSize);
+
+/*
+ * @Read the next unexpired record
+ *
+ * @param
+ *  snap: snapshot opened by hash_snapshot_load
+ *  key: filled with keySize bytes
+ *  value: filled with valueSize bytes
+ *  expired: the expiry time converted to the TSC of this process
+ *
+ * @return
+ *  1: a record is read
+ *  0: end of the part
+ *  -1: read failed
+ */
+int hash_snapshot_next(struct HashSnapshot *snap, void *key, void *value, uint64_t *expired);
+
+/*
+ * @Restore a part of a snapshot into a hash table
+ *
+ * Records are inserted with hash_table_insert_key, HashTableOps keyHashFunc must be provided.
+ *
+ * @param
+ *  htbl: hash table filled
+ *  path: snapshot file
+ *  part: the part restored, from 0 to parts-1
+ *  parts: number of parts
+ *  keySize: size of the key struct
+ *  valueSize: size of the value struct
+ *  restore: allocate the key/value objects, NULL for HASH_STRATEGY_INLINE which copies them
+ *  release: give back the objects the table did not keep, insert returned RET_OCCUPY or RET_FAILED
+ *  userData: passed to restore
+ *
+ * @return
+ *  the number of nodes inserted, -1 if failed
+ */
+int64_t hash_table_restore(struct hashTable *htbl, const char *path, unsigned int part, unsigned int parts,
+		unsigned int keySize, unsigned int valueSize, fpRestoreNode restore, fpExpireNode release, void *userData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -6,14 +6,98 @@
 #include <rte_atomic.h>
 #include <rte_cycles.h>
 #include <rte_rwlock.h>
+#include <rte_spinlock.h>
+#include <rte_memory.h>
+#include <rte_common.h>
+#include <rte_vect.h>
+#include <rte_lcore.h>
+#include <rte_branch_prediction.h>
+#include <rte_prefetch.h>
 
 #include "hashTable.h"
 
 #define PROBE_COUNT 5
 
+/*cuckoo mode: 8 signatures per bucket, two candidate buckets per key*/
+#define CUCKOO_BUCKET_ENTRIES 8
+#define CUCKOO_MAX_PATH 64
+#define CUCKOO_LOAD_PERCENT 90
+#define CUCKOO_SIG_EMPTY 0
+
+/*inline mode: key and value copied into slots packed by cache line*/
+#define INLINE_GROUP_SLOTS 4
+#define INLINE_LOAD_FACTOR 2
+
+/*Robin Hood mode: slots per node of capacity and default bound of the distance to the home slot*/
+#define ROBIN_LOAD_PERCENT 85
+#define ROBIN_MAX_DISPLACEMENT 32
+#define ROBIN_DIST_LIMIT UINT16_MAX
+
+/*online resize: slots moved per insert and per maintenance call*/
+#define HASH_MIGRATE_STEP 8
+#define HASH_MAINTAIN_STEP 1024
+#define HASH_SAMPLE_SLOTS 256
+#define HASH_GROW_PERCENT 90
+#define HASH_SHRINK_PERCENT 20
+
+/*expiry: slots sharing one earliest-expiry time, skipped by the sweep until it is reached*/
+#define HASH_EXPIRE_SEGMENT 256
+#define HASH_EXPIRE_NONE UINT64_MAX
+
+/*
+ * HASH_TABLE_F_SOA_META: slots of one scan, about ticks per second and the farthest expiry in
+ * ticks, a later one is stored as the horizon and refreshed by the sweep once it is reached
+ */
+#define HASH_META_SCAN 32
+#define HASH_TICK_HZ 1024
+#define HASH_TICK_HORIZON (1U << 30)
+
+/*
+ * HASH_TABLE_F_IP_INDEX: slots per chain head, end of a chain, multiplier spreading the /24 of an
+ * address over the heads and slots collected per pass of an invalidation
+ */
+#define HASH_IP_SLOTS_PER_HEAD 4
+#define HASH_IP_NONE UINT32_MAX
+#define HASH_IP_MUL 0x9E3779B1u
+#define HASH_IP_BATCH 64
+
+/*blocked Bloom filter: bits per node of capacity, bits set per key, work of a maintenance call*/
+#define HASH_FILTER_BITS_PER_KEY 10
+#define HASH_FILTER_HASHES 4
+#define HASH_FILTER_MUL 0x9E3779B97F4A7C15ULL
+#define HASH_FILTER_SCAN_STEP 4096
+#define HASH_FILTER_CLEAR_STEP 4096
+#define HASH_FILTER_REBUILD_PERCENT 50
+
+/*
+ * TinyLFU admission: 4-bit counters per node of capacity, rows of a key, accesses per node of
+ * capacity before all counters are halved, words halved by a maintenance call, accesses an lcore
+ * counts locally before adding them to the shared total, the saturated counter and the mask
+ * clearing the bit shifted into each counter by halving
+ */
+#define HASH_SKETCH_COUNTERS_PER_KEY 8
+#define HASH_SKETCH_DEPTH 4
+#define HASH_SKETCH_SAMPLE_FACTOR 10
+#define HASH_SKETCH_AGE_STEP 4096
+#define HASH_SKETCH_BATCH 1024
+#define HASH_SKETCH_COUNTER_MAX 15
+#define HASH_SKETCH_HALF 0x7777777777777777ULL
+
+/*write-combining: nodes staged per lcore, age in microseconds at which maintain flushes them, prefetch distance of a flush*/
+#define HASH_STAGE_SIZE 32
+#define HASH_STAGE_FLUSH_US 200
+#define HASH_STAGE_PREFETCH 4
+
+/*owner of the objects of a list node which was inserted outside of any lcore*/
+#define HASH_OWNER_NONE UINT16_MAX
+
 #define STATUS_AVAILABLE 0
 #define STATUS_INIT 1
 #define STATUS_USE 2
+/*the node has been moved to the new array by a resize*/
+#define STATUS_MIGRATED 3
+/*tombstone of a deleted or expired node, lookups go on past it*/
+#define STATUS_DELETED 4
 
 struct ListElem
 {
@@ -23,323 +107,4975 @@ struct ListElem
 
 	void *key;
 	void *value;
+	/*kept to rehash the node without the original data*/
+	unsigned int hash;
+	/*CLOCK reference bit, set by lookups without the write lock*/
+	volatile uint8_t ref;
+	/*lcore which supplied key and value, HASH_OWNER_NONE if unknown*/
+	uint16_t owner;
+};
+
+/*
+ * Bucket array of the list strategies. size and elem are published together through one
+ * pointer, so a resize can swap the array under concurrent lookups.
+ */
+struct ListArray
+{
+	unsigned int size;
+	unsigned int total;
+	/*migration progress when this is the old array of a resize*/
+	rte_atomic32_t cursor;
+	rte_atomic32_t migrated;
+	/*earliest expiry time of each HASH_EXPIRE_SEGMENT slots, stored behind elem*/
+	volatile uint64_t *expire;
+	/*
+	 * HASH_TABLE_F_SOA_META: status byte and coarse expiry tick of each slot, stored behind
+	 * expire. They are written with the slot locked and read by the scans without a lock, a
+	 * scan only picks candidate slots which are checked again under their lock.
+	 */
+	volatile uint8_t *meta;
+	volatile uint32_t *tick;
+	/*
+	 * HASH_TABLE_F_IP_INDEX: the used slots are chained by the /24 of their address through
+	 * ipNext and ipPrev from one of ipHeads heads. ipOf is the address a slot is chained under,
+	 * 0 while it is not. A chain is changed with the slot write-locked and its head locked.
+	 */
+	uint32_t *ipHead;
+	rte_spinlock_t *ipLock;
+	uint32_t *ipNext;
+	uint32_t *ipPrev;
+	uint32_t *ipOf;
+	unsigned int ipHeads;
+	struct ListElem elem[0];
+};
+
+/*quiescent state of an lcore, reported by hash_table_maintain*/
+struct HashLcoreState
+{
+	volatile uint64_t epoch;
+	int online;
+} __rte_cache_aligned;
+
+/*
+ * The 16-bit signatures of a bucket occupy one cache line together with the bucket lock,
+ * so checking both candidate buckets of a key touches at most two cache lines.
+ * The entries are kept in a separate array indexed by bucket*CUCKOO_BUCKET_ENTRIES+slot.
+ */
+struct CuckooBucket
+{
+	uint16_t sig[CUCKOO_BUCKET_ENTRIES];
+	rte_rwlock_t rwlock;
+} __rte_cache_aligned;
+
+struct CuckooEntry
+{
+	uint64_t timeout;
+
+	void *key;
+	void *value;
+};
+
+/*
+ * Inline probe group. The header and as many slots as fit share one cache line, a slot is
+ * the expiry time followed by keySize bytes of key and valueSize bytes of value. With the
+ * 16-byte struct key and 12-byte struct value of CCAlg one slot fits in a line.
+ */
+struct InlineGroupHeader
+{
+	rte_rwlock_t rwlock;
+	uint8_t status[INLINE_GROUP_SLOTS];
+};
+
+struct InlineSlot
+{
+	uint64_t timeout;
+	unsigned char data[0];
+} __attribute__((packed));
+
+/*two slots per cache line, dist is the number of slots between the slot and the home slot of the node*/
+struct RobinSlot
+{
+	uint64_t timeout;
+
+	void *key;
+	void *value;
+	unsigned int hash;
+	uint16_t dist;
+	uint16_t status;
+};
+
+/*one cache line of the filter, all the bits of a key are in the same block*/
+struct HashFilterBlock
+{
+	uint64_t word[RTE_CACHE_LINE_SIZE/sizeof(uint64_t)];
+} __rte_cache_aligned;
+
+enum HASH_FILTER_STATE
+{
+	/*waiting for enough inserts since the last rebuild*/
+	HASH_FILTER_IDLE,
+	/*clearing the spare buffer*/
+	HASH_FILTER_CLEAR,
+	/*the spare buffer is published to the inserts, waiting for the inserts which missed it*/
+	HASH_FILTER_PUBLISHED,
+	/*scanning the table into the spare buffer*/
+	HASH_FILTER_SCAN
+};
+
+/*a node inserted by an lcore of a HASH_TABLE_F_WRITE_COMBINE table and not flushed yet*/
+struct HashStageEntry
+{
+	void *key;
+	void *value;
+	uint64_t timeout;
+	/*staged by an upsert, the flush leaves a node of the key written meanwhile alone*/
+	int upsert;
 };
 
+struct HashStage
+{
+	unsigned int count;
+	/*when the oldest staged node was staged*/
+	uint64_t since;
+	unsigned int hash[HASH_STAGE_SIZE];
+	struct HashStageEntry entry[HASH_STAGE_SIZE];
+	/*key and value copies of HASH_STRATEGY_INLINE, which never keeps the pointers it is given*/
+	unsigned char *data;
+} __rte_cache_aligned;
+
 struct HashTableStatis
 {
-	rte_atomic32_t failed;
-	rte_atomic32_t collision;
 	unsigned int totalMem;
 };
 
-typedef int (*fpInsert)(struct hashTable *htbl, void *data, int dLen, void *key, void *value, uint64_t timeout);
-typedef void* (*fpSearch)(struct hashTable *htbl, void *data, int dLen, void *key, void *copy, struct UpdateCallBack *callback);
+/*
+ * Counters of one lcore, only written by it and summed by hash_table_stats. Threads which are
+ * not EAL lcores share the last slot and may lose some counts.
+ */
+struct HashLcoreStats
+{
+	uint64_t insert;
+	uint64_t occupy;
+	uint64_t hit;
+	uint64_t miss;
+	uint64_t failed;
+	uint64_t collision;
+	uint64_t eviction;
+	uint64_t expiration;
+	uint64_t deletion;
+	uint64_t filtered;
+	uint64_t staged;
+	uint64_t rejected;
+	/*accesses recorded in the sketch and not added to sketchSamples yet*/
+	uint64_t sketched;
+	uint64_t probe[HASH_STATS_PROBE_MAX];
+} __rte_cache_aligned;
+
+typedef int (*fpInsert)(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout);
+typedef int (*fpUpsert)(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout, struct UpsertCallBack *callback, struct HashNodeCopy *cp);
+/*return the value of the node found, NULL if not find*/
+typedef void* (*fpSearch)(struct hashTable *htbl, unsigned int hash, void *key, void *copy, struct UpdateCallBack *callback);
+typedef int (*fpInit)(struct hashTable *htbl, int size);
+typedef void (*fpRelease)(struct hashTable *htbl);
+typedef void (*fpTravel)(struct hashTable *htbl, uint64_t current, int *cnt, int *timeout, int *available);
+typedef int (*fpResize)(struct hashTable *htbl, unsigned int capacity);
+typedef void (*fpMaintain)(struct hashTable *htbl);
+/*stage 0 prefetches the buckets of the hash, stage 1 what the bucket content points to*/
+typedef void (*fpPrefetch)(struct hashTable *htbl, unsigned int hash, int stage);
+/*reclaim the expired nodes of the slots [start, end), next is lowered to the earliest expiry left*/
+typedef int (*fpSweep)(struct hashTable *htbl, void *arr, unsigned int start, unsigned int end, uint64_t current, uint64_t *next);
+typedef int (*fpExpire)(struct hashTable *htbl, unsigned int budget);
+typedef int (*fpRemove)(struct hashTable *htbl, unsigned int hash, void *key, void *copy);
+/*visit the live nodes of the slots [start, end), next is set where the walk stopped*/
+typedef int (*fpIterate)(struct hashTable *htbl, unsigned int start, unsigned int end, fpVisit visit, void *userData, unsigned int *next);
+/*give back expired nodes, then the oldest nodes of owner until want of its nodes were given back*/
+typedef int (*fpReclaim)(struct hashTable *htbl, unsigned int owner, unsigned int want, unsigned int budget);
+/*delete the nodes indexed under an address of the prefix*/
+typedef int (*fpInvalidate)(struct hashTable *htbl, uint32_t ip, unsigned int prefixLen);
 
 struct HashInterface
 {
 	fpInsert insert;
 	fpSearch search;
+	fpInit init;
+	fpRelease release;
+	fpTravel travel;
+	fpResize resize;
+	fpMaintain maintain;
+	fpPrefetch prefetch;
+	fpExpire expire;
+	fpRemove remove;
+	fpIterate iterate;
+	fpUpsert upsert;
+	fpReclaim reclaim;
+	fpInvalidate invalidate;
 };
 
 struct hashTable
 {
-	struct ListElem *bucket;
+	struct ListArray *volatile list;
 	unsigned int bucketSize;
 	unsigned int capacity;
 
+	/*online resize of the list strategies*/
+	struct ListArray *volatile old;
+	struct ListArray *retired;
+	volatile uint64_t epoch;
+	uint64_t retireEpoch;
+	rte_spinlock_t resizeLock;
+	rte_spinlock_t autoLock;
+	unsigned int initCapacity;
+	unsigned int minCapacity;
+	unsigned int maxCapacity;
+	unsigned int sampleCursor;
+	unsigned int lastFailed;
+	uint64_t estimateUsed;
+	/*HASH_TABLE_F_SOA_META: the tick of a time is time >> tickShift*/
+	unsigned int tickShift;
+
 	enum HASH_STRATEGY mode;
 	int probeStep;
 	int factor;
 
+	struct CuckooBucket *cbucket;
+	struct CuckooEntry *centry;
+	unsigned int cbucketMask;
+	unsigned int victim;
+	/*serialize cuckoo writers, readers retry their lookup if change moved during it*/
+	rte_spinlock_t writeLock;
+	volatile uint32_t change;
+
+	/*Robin Hood mode, it shares writeLock and change with the cuckoo mode*/
+	struct RobinSlot *rslot;
+	unsigned int maxDisplacement;
+	/*largest distance of any node ever placed, bounds the lookups*/
+	volatile unsigned int longest;
+
+	unsigned char *group;
+	void *groupMem;
+	unsigned int groupMask;
+	unsigned int groupSize;
+	unsigned int slotSize;
+	int slotsPerGroup;
+	int probeGroups;
+
+	/*
+	 * HASH_TABLE_F_FILTER: the lookups check filter, the inserts set their bits in filter and
+	 * in filterBuild while a rebuild publishes it. Both buffers share filterMem.
+	 */
+	struct HashFilterBlock *volatile filter;
+	struct HashFilterBlock *volatile filterBuild;
+	struct HashFilterBlock *filterSpare;
+	void *filterMem;
+	unsigned int filterMask;
+	unsigned int filterCursor;
+	enum HASH_FILTER_STATE filterState;
+	uint64_t filterEpoch;
+	uint64_t filterInserted;
+	struct ListArray *filterList;
+	rte_spinlock_t filterLock;
+
+	/*
+	 * HASH_TABLE_F_ADMISSION: count-min sketch of the accesses, 16 counters per word. All the
+	 * counters are halved once sketchSamples reaches sketchPeriod, sketchCursor words at a time.
+	 */
+	volatile uint64_t *sketch;
+	unsigned int sketchMask;
+	unsigned int sketchCursor;
+	uint64_t sketchPeriod;
+	rte_atomic64_t sketchSamples;
+	rte_spinlock_t sketchLock;
+
+	/*
+	 * HASH_TABLE_F_WRITE_COMBINE: the stage of each lcore and the memory of the inline copies.
+	 */
+	struct HashStage *stage;
+	void *stageMem;
+	unsigned char *stageData;
+	uint64_t stageAge;
+
+	/*expiry segments of the cuckoo and inline layouts*/
+	volatile uint64_t *segExpire;
+	rte_atomic32_t expireCursor;
+	/*next window of slots walked by hash_table_reclaim*/
+	rte_atomic32_t reclaimCursor;
+
 	struct HashInterface *inf;
 	struct HashTableOps ops;
 	struct HashTableStatis st;
+
+	struct HashLcoreState qs[RTE_MAX_LCORE];
+	struct HashLcoreStats stats[RTE_MAX_LCORE+1];
+};
+
+static void *HashDefaultMalloc(size_t size)
+{
+	return malloc(size);
+}
+
+static void HashDefaultFree(void *ptr, int len)
+{
+	free(ptr);
+}
+
+static void *HashMalloc(struct hashTable *htbl, size_t size)
+{
+	if( htbl->ops.mallocSocketFunc )
+	{
+		return htbl->ops.mallocSocketFunc(size, htbl->ops.socket);
+	}
+	return htbl->ops.mallocFunc(size);
+}
+
+/*a table with a single owner lcore is never accessed concurrently and takes no lock*/
+static inline void HashReadLock(struct hashTable *htbl, rte_rwlock_t *rwl)
+{
+	if( !(htbl->ops.flags & HASH_TABLE_F_SINGLE_OWNER) )
+	{
+		rte_rwlock_read_lock(rwl);
+	}
+}
+
+static inline void HashReadUnlock(struct hashTable *htbl, rte_rwlock_t *rwl)
+{
+	if( !(htbl->ops.flags & HASH_TABLE_F_SINGLE_OWNER) )
+	{
+		rte_rwlock_read_unlock(rwl);
+	}
+}
+
+static inline void HashWriteLock(struct hashTable *htbl, rte_rwlock_t *rwl)
+{
+	if( !(htbl->ops.flags & HASH_TABLE_F_SINGLE_OWNER) )
+	{
+		rte_rwlock_write_lock(rwl);
+	}
+}
+
+static inline void HashWriteUnlock(struct hashTable *htbl, rte_rwlock_t *rwl)
+{
+	if( !(htbl->ops.flags & HASH_TABLE_F_SINGLE_OWNER) )
+	{
+		rte_rwlock_write_unlock(rwl);
+	}
+}
+
+/*table whose writeLock the calling thread holds over a whole flush of its stage*/
+static __thread struct hashTable *tHashFlushing = NULL;
+
+/*a flush of the stage takes the writer lock once for all its nodes, the inserts it runs skip it*/
+static inline int HashFlushHolds(struct hashTable *htbl, rte_spinlock_t *sl)
+{
+	return tHashFlushing == htbl && sl == &htbl->writeLock;
+}
+
+static inline void HashSpinLock(struct hashTable *htbl, rte_spinlock_t *sl)
+{
+	if( !(htbl->ops.flags & HASH_TABLE_F_SINGLE_OWNER) && !HashFlushHolds(htbl, sl) )
+	{
+		rte_spinlock_lock(sl);
+	}
+}
+
+static inline void HashSpinUnlock(struct hashTable *htbl, rte_spinlock_t *sl)
+{
+	if( !(htbl->ops.flags & HASH_TABLE_F_SINGLE_OWNER) && !HashFlushHolds(htbl, sl) )
+	{
+		rte_spinlock_unlock(sl);
+	}
+}
+
+static inline struct HashLcoreStats *HashStats(struct hashTable *htbl)
+{
+	unsigned int lcore = rte_lcore_id();
+
+	return &htbl->stats[lcore < RTE_MAX_LCORE ? lcore : RTE_MAX_LCORE];
+}
+
+#define HASH_STAT_INC(htbl, field) (HashStats(htbl)->field++)
+#define HASH_STAT_ADD(htbl, field, n) (HashStats(htbl)->field += (n))
+
+/*count a lookup, probes is the number of slots, buckets or groups examined*/
+static inline void HashStatLookup(struct hashTable *htbl, int find, int probes)
+{
+	struct HashLcoreStats *stats = HashStats(htbl);
+
+	if( find )
+	{
+		stats->hit++;
+	}
+	else
+	{
+		stats->miss++;
+	}
+	stats->probe[RTE_MIN(RTE_MAX(probes, 1), HASH_STATS_PROBE_MAX) - 1]++;
+}
+
+static uint64_t HashStatFailed(struct hashTable *htbl)
+{
+	uint64_t failed = 0;
+	unsigned int i = 0;
+
+	for( ; i <= RTE_MAX_LCORE; i++)
+	{
+		failed += htbl->stats[i].failed;
+	}
+	return failed;
+}
+
+static inline unsigned int HashSegments(unsigned int slots)
+{
+	return (slots + HASH_EXPIRE_SEGMENT - 1)/HASH_EXPIRE_SEGMENT;
+}
+
+/*
+ * Lower the earliest expiry time of the segment of a slot. It must be called while holding the
+ * lock of the slot, so a sweep that resets the segment either sees the node or its update.
+ */
+static inline void HashNoteExpire(volatile uint64_t *segExpire, unsigned int idx, uint64_t timeout)
+{
+	volatile uint64_t *seg = &segExpire[idx/HASH_EXPIRE_SEGMENT];
+	uint64_t cur = *seg;
+
+	while( timeout < cur && !rte_atomic64_cmpset(seg, cur, timeout) )
+	{
+		cur = *seg;
+	}
+}
+
+static int AllocSegments(struct hashTable *htbl, unsigned int slots)
+{
+	htbl->segExpire = HashMalloc(htbl, sizeof(uint64_t)*HashSegments(slots));
+	if( !htbl->segExpire )
+	{
+		return -1;
+	}
+	memset((void*)(uintptr_t)htbl->segExpire, 0xff, sizeof(uint64_t)*HashSegments(slots));
+	htbl->st.totalMem += sizeof(uint64_t)*HashSegments(slots);
+
+	return 0;
+}
+
+static void FreeSegments(struct hashTable *htbl, unsigned int slots)
+{
+	if( htbl->segExpire )
+	{
+		htbl->ops.freeFunc((void*)(uintptr_t)htbl->segExpire, sizeof(uint64_t)*HashSegments(slots));
+	}
+}
+
+/*
+ * Walk the segments from the shared cursor. A segment whose earliest expiry is still in the future
+ * is skipped without touching its slots, so the work of a call is bounded by budget and mostly
+ * spent where nodes actually expired.
+ *
+ * @return
+ *  the number of nodes reclaimed
+ */
+static int HashExpireSegments(struct hashTable *htbl, volatile uint64_t *segExpire, unsigned int slots, fpSweep sweep, void *arr, unsigned int budget)
+{
+	unsigned int segCount = HashSegments(slots);
+	unsigned int visited = 0;
+	unsigned int seg = 0;
+	uint64_t current = rte_rdtsc();
+	uint64_t next = 0;
+	int reclaimed = 0;
+
+	while( budget > 0 && visited < segCount )
+	{
+		visited++;
+		seg = (unsigned int)(rte_atomic32_add_return(&htbl->expireCursor, 1) - 1)%segCount;
+		if( segExpire[seg] > current )
+		{
+			budget--;
+			continue;
+		}
+
+		segExpire[seg] = HASH_EXPIRE_NONE;
+		rte_smp_mb();
+		next = HASH_EXPIRE_NONE;
+		reclaimed += sweep(htbl, arr, seg*HASH_EXPIRE_SEGMENT, RTE_MIN((seg+1)*HASH_EXPIRE_SEGMENT, slots), current, &next);
+		HashNoteExpire(segExpire, seg*HASH_EXPIRE_SEGMENT, next);
+		budget -= RTE_MIN(budget, HASH_EXPIRE_SEGMENT);
+	}
+	HASH_STAT_ADD(htbl, expiration, reclaimed);
+
+	return reclaimed;
+}
+
+static inline size_t ListMetaOffset(unsigned int total)
+{
+	return RTE_ALIGN_CEIL(sizeof(struct ListArray) + sizeof(struct ListElem)*total + sizeof(uint64_t)*HashSegments(total), RTE_CACHE_LINE_SIZE);
+}
+
+static inline size_t ListIndexOffset(struct hashTable *htbl, unsigned int total)
+{
+	if( htbl->ops.flags & HASH_TABLE_F_SOA_META )
+	{
+		return ListMetaOffset(total) + RTE_ALIGN_CEIL(total, RTE_CACHE_LINE_SIZE) + sizeof(uint32_t)*total;
+	}
+	return sizeof(struct ListArray) + sizeof(struct ListElem)*total + sizeof(uint64_t)*HashSegments(total);
+}
+
+static inline unsigned int ListIpHeads(unsigned int total)
+{
+	return total/HASH_IP_SLOTS_PER_HEAD + 1;
+}
+
+static inline size_t ListArraySize(struct hashTable *htbl, unsigned int total)
+{
+	if( htbl->ops.flags & HASH_TABLE_F_IP_INDEX )
+	{
+		return RTE_ALIGN_CEIL(ListIndexOffset(htbl, total), RTE_CACHE_LINE_SIZE) +
+			(sizeof(uint32_t) + sizeof(rte_spinlock_t))*ListIpHeads(total) + sizeof(uint32_t)*3*total;
+	}
+	return ListIndexOffset(htbl, total);
+}
+
+static struct ListArray *AllocList(struct hashTable *htbl, unsigned int size)
+{
+	struct ListArray *arr = NULL;
+	unsigned int total = 0;
+	unsigned int i = 0;
+
+	/*the probe sequence of the last slots runs into a tail instead of past the array*/
+	total = size + htbl->probeStep + 1;
+	arr = HashMalloc(htbl, ListArraySize(htbl, total));
+	if( !arr )
+	{
+		return NULL;
+	}
+	memset(arr, 0x00, sizeof(struct ListArray) + sizeof(struct ListElem)*total);
+	arr->size = size;
+	arr->total = total;
+	arr->expire = (volatile uint64_t*)&arr->elem[total];
+	memset((void*)(uintptr_t)arr->expire, 0xff, sizeof(uint64_t)*HashSegments(total));
+	if( htbl->ops.flags & HASH_TABLE_F_SOA_META )
+	{
+		arr->meta = (volatile uint8_t*)arr + ListMetaOffset(total);
+		arr->tick = (volatile uint32_t*)(arr->meta + RTE_ALIGN_CEIL(total, RTE_CACHE_LINE_SIZE));
+		memset((void*)(uintptr_t)arr->meta, STATUS_AVAILABLE, total);
+		memset((void*)(uintptr_t)arr->tick, 0x00, sizeof(uint32_t)*total);
+	}
+	if( htbl->ops.flags & HASH_TABLE_F_IP_INDEX )
+	{
+		arr->ipHeads = ListIpHeads(total);
+		arr->ipLock = (rte_spinlock_t*)((unsigned char*)arr + RTE_ALIGN_CEIL(ListIndexOffset(htbl, total), RTE_CACHE_LINE_SIZE));
+		arr->ipHead = (uint32_t*)&arr->ipLock[arr->ipHeads];
+		arr->ipNext = &arr->ipHead[arr->ipHeads];
+		arr->ipPrev = &arr->ipNext[total];
+		arr->ipOf = &arr->ipPrev[total];
+		memset(arr->ipHead, 0xff, sizeof(uint32_t)*arr->ipHeads);
+		memset(arr->ipOf, 0x00, sizeof(uint32_t)*total);
+		for( i = 0; i < arr->ipHeads; i++)
+		{
+			rte_spinlock_init(&arr->ipLock[i]);
+		}
+	}
+	for( i = 0; i < total; i++)
+	{
+		rte_rwlock_init(&(arr->elem[i].rwlock));
+	}
+
+	return arr;
+}
+
+static void FreeList(struct hashTable *htbl, struct ListArray *arr)
+{
+	if( arr )
+	{
+		htbl->ops.freeFunc(arr, ListArraySize(htbl, arr->total));
+	}
+}
+
+/*HASH_META_SCAN slots from start, bit i stands for slot start+i*/
+struct ListMetaScan
+{
+	uint32_t used;
+	uint32_t deleted;
+	/*available or deleted*/
+	uint32_t free;
+	/*used nodes whose tick was reached, they may have expired*/
+	uint32_t due;
+	/*ticks before the used node expiring first among the others, INT32_MAX if none*/
+	int32_t wait;
 };
 
-static void *HashDefaultMalloc(size_t size)
+/*
+ * Classify n <= HASH_META_SCAN slots from their status bytes and ticks. A full scan compares the 32
+ * status bytes with one instruction and 8 ticks with each of the next four, ticks are compared
+ * as distances to now so they may wrap.
+ */
+static inline void ListScanMeta(struct ListArray *arr, unsigned int start, unsigned int n, uint32_t now, struct ListMetaScan *scan)
+{
+	unsigned int i = 0;
+	int32_t dist = 0;
+
+#if defined(RTE_MACHINE_CPUFLAG_AVX2)
+	if( n == HASH_META_SCAN )
+	{
+		__m256i meta = _mm256_loadu_si256((const __m256i*)(uintptr_t)(arr->meta + start));
+		__m256i nowTick = _mm256_set1_epi32(now);
+		__m256i none = _mm256_set1_epi32(INT32_MAX);
+		__m256i wait = none;
+		__m256i lane;
+		__m256i live;
+		__m128i low;
+		uint32_t ahead = 0;
+
+		scan->used = _mm256_movemask_epi8(_mm256_cmpeq_epi8(meta, _mm256_set1_epi8(STATUS_USE)));
+		scan->deleted = _mm256_movemask_epi8(_mm256_cmpeq_epi8(meta, _mm256_set1_epi8(STATUS_DELETED)));
+		scan->free = _mm256_movemask_epi8(_mm256_cmpeq_epi8(meta, _mm256_setzero_si256())) | scan->deleted;
+		for( ; i < HASH_META_SCAN/8; i++)
+		{
+			lane = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(uintptr_t)(arr->tick + start + i*8)), nowTick);
+			live = _mm256_and_si256(_mm256_cmpgt_epi32(lane, _mm256_setzero_si256()),
+					_mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(uintptr_t)(arr->meta + start + i*8))), _mm256_set1_epi32(STATUS_USE)));
+			ahead |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(live)) << (i*8);
+			wait = _mm256_min_epi32(wait, _mm256_blendv_epi8(none, lane, live));
+		}
+		scan->due = scan->used & ~ahead;
+		low = _mm_min_epi32(_mm256_castsi256_si128(wait), _mm256_extracti128_si256(wait, 1));
+		low = _mm_min_epi32(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(1, 0, 3, 2)));
+		low = _mm_min_epi32(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(2, 3, 0, 1)));
+		scan->wait = _mm_cvtsi128_si32(low);
+		return;
+	}
+#endif
+	memset(scan, 0x00, sizeof(*scan));
+	scan->wait = INT32_MAX;
+	for( ; i < n; i++)
+	{
+		switch( arr->meta[start+i] )
+		{
+			case STATUS_USE:
+				scan->used |= 1U << i;
+				dist = (int32_t)(arr->tick[start+i] - now);
+				if( dist <= 0 )
+				{
+					scan->due |= 1U << i;
+				}
+				else if( dist < scan->wait )
+				{
+					scan->wait = dist;
+				}
+				break;
+			case STATUS_DELETED:
+				scan->deleted |= 1U << i;
+				scan->free |= 1U << i;
+				break;
+			case STATUS_AVAILABLE:
+				scan->free |= 1U << i;
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+static inline uint32_t HashTickOf(struct hashTable *htbl, uint64_t time)
+{
+	return (uint32_t)(time >> htbl->tickShift);
+}
+
+static int InitList(struct hashTable *htbl, int size)
+{
+	htbl->capacity = size;
+	htbl->initCapacity = size;
+	htbl->bucketSize = htbl->factor*size;
+	while( (rte_get_tsc_hz() >> (htbl->tickShift+1)) >= HASH_TICK_HZ )
+	{
+		htbl->tickShift++;
+	}
+	htbl->list = AllocList(htbl, htbl->bucketSize);
+	if( !htbl->list )
+	{
+		printf("Malloc bucket failed.\n");
+		return -1;
+	}
+	rte_spinlock_init(&htbl->resizeLock);
+	htbl->st.totalMem = sizeof(*htbl) + ListArraySize(htbl, htbl->list->total);
+
+	return 0;
+}
+
+static void ReleaseList(struct hashTable *htbl)
+{
+	if( htbl->old && htbl->old != htbl->list )
+	{
+		FreeList(htbl, htbl->old);
+	}
+	FreeList(htbl, htbl->retired);
+	FreeList(htbl, htbl->list);
+}
+
+static void TravelList(struct hashTable *htbl, uint64_t current, int *cnt, int *timeout, int *available)
+{
+	struct ListArray *arr = htbl->list;
+	struct ListMetaScan scan;
+	uint32_t mask = 0;
+	unsigned int n = 0;
+	unsigned int i = 0;
+
+	/*only the nodes whose tick was reached have their timeout read, the values only for assessFunc*/
+	for( ; arr->meta && i < arr->total; i += n)
+	{
+		n = RTE_MIN(arr->total - i, HASH_META_SCAN);
+		ListScanMeta(arr, i, n, HashTickOf(htbl, current), &scan);
+		*cnt += __builtin_popcount(scan.used);
+		*available += __builtin_popcount(scan.free);
+		/*LRU keeps no tick, its timeout is the access time*/
+		for( mask = (htbl->mode != HASH_STRATEGY_LRU)?scan.due:scan.used; mask; mask &= mask - 1)
+		{
+			if( arr->elem[i + __builtin_ctz(mask)].timeout < current )
+			{
+				(*timeout)++;
+			}
+		}
+		for( mask = htbl->ops.assessFunc?scan.used:0; mask; mask &= mask - 1)
+		{
+			htbl->ops.assessFunc(arr->elem[i + __builtin_ctz(mask)].value);
+		}
+	}
+
+	for( ; i < arr->total; i++)
+	{
+		if( arr->elem[i].status == STATUS_USE )
+		{
+			(*cnt)++;
+			if( htbl->ops.assessFunc )
+			{
+				htbl->ops.assessFunc(arr->elem[i].value);
+			}
+			if( arr->elem[i].timeout < current )
+			{
+				(*timeout)++;
+			}
+		}
+		else if( arr->elem[i].status == STATUS_AVAILABLE || arr->elem[i].status == STATUS_DELETED )
+		{
+			(*available)++;
+		}
+	}
+}
+
+/*an lcore is tracked by the quiescent state check from its first access to the table*/
+static inline void ListOnline(struct hashTable *htbl)
+{
+	unsigned int lcore = rte_lcore_id();
+
+	if( lcore < RTE_MAX_LCORE && unlikely(!htbl->qs[lcore].online) )
+	{
+		htbl->qs[lcore].epoch = htbl->epoch;
+		htbl->qs[lcore].online = 1;
+		rte_smp_mb();
+	}
+}
+
+/*every lcore accessing the table went through hash_table_maintain since epoch was reached*/
+static int HashQuiescent(struct hashTable *htbl, uint64_t epoch)
+{
+	unsigned int i = 0;
+
+	for( ; i < RTE_MAX_LCORE; i++)
+	{
+		if( htbl->qs[i].online && htbl->qs[i].epoch < epoch )
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static uint64_t HashNextEpoch(struct hashTable *htbl)
+{
+	uint64_t epoch = 0;
+
+	HashSpinLock(htbl, &htbl->resizeLock);
+	epoch = ++htbl->epoch;
+	HashSpinUnlock(htbl, &htbl->resizeLock);
+	return epoch;
+}
+
+static uint64_t HashStatInserted(struct hashTable *htbl)
+{
+	uint64_t inserted = 0;
+	unsigned int i = 0;
+
+	for( ; i <= RTE_MAX_LCORE; i++)
+	{
+		inserted += htbl->stats[i].insert + htbl->stats[i].occupy;
+	}
+	return inserted;
+}
+
+static int InitFilter(struct hashTable *htbl, unsigned int capacity)
+{
+	unsigned int count = 0;
+	size_t size = 0;
+
+	count = ((uint64_t)capacity*HASH_FILTER_BITS_PER_KEY + sizeof(struct HashFilterBlock)*8 - 1)/(sizeof(struct HashFilterBlock)*8);
+	count = rte_align32pow2(count > 1 ? count : 2);
+	size = sizeof(struct HashFilterBlock)*count;
+
+	/*two buffers, each block must be one cache line whatever the allocator returns*/
+	htbl->filterMem = HashMalloc(htbl, size*2 + RTE_CACHE_LINE_SIZE);
+	if( !htbl->filterMem )
+	{
+		return -1;
+	}
+	htbl->filterMask = count - 1;
+	htbl->filter = (struct HashFilterBlock*)RTE_ALIGN_CEIL((uintptr_t)htbl->filterMem, RTE_CACHE_LINE_SIZE);
+	htbl->filterSpare = htbl->filter + count;
+	htbl->filterBuild = NULL;
+	memset(htbl->filter, 0x00, size*2);
+	htbl->filterState = HASH_FILTER_IDLE;
+	rte_spinlock_init(&htbl->filterLock);
+	htbl->st.totalMem += size*2;
+
+	return 0;
+}
+
+static void ReleaseFilter(struct hashTable *htbl)
+{
+	if( htbl->filterMem )
+	{
+		htbl->ops.freeFunc(htbl->filterMem, sizeof(struct HashFilterBlock)*(htbl->filterMask+1)*2 + RTE_CACHE_LINE_SIZE);
+	}
+}
+
+/*
+ * The block is picked by the low bits of the hash, the bits inside it by the high bits of a
+ * multiplicative remix, so they do not repeat the block index.
+ */
+static inline void FilterSet(struct hashTable *htbl, struct HashFilterBlock *filter, unsigned int hash)
+{
+	struct HashFilterBlock *b = &filter[hash & htbl->filterMask];
+	uint64_t m = (uint64_t)hash*HASH_FILTER_MUL;
+	uint64_t bit = 0;
+	int i = 0;
+
+	for( ; i < HASH_FILTER_HASHES; i++, m <<= 9)
+	{
+		bit = m >> 55;
+		if( !(b->word[bit>>6] & (1ULL<<(bit&63))) )
+		{
+			__sync_fetch_and_or(&b->word[bit>>6], 1ULL<<(bit&63));
+		}
+	}
+}
+
+static inline int FilterTest(struct hashTable *htbl, struct HashFilterBlock *filter, unsigned int hash)
+{
+	struct HashFilterBlock *b = &filter[hash & htbl->filterMask];
+	uint64_t m = (uint64_t)hash*HASH_FILTER_MUL;
+	uint64_t bit = 0;
+	int i = 0;
+
+	for( ; i < HASH_FILTER_HASHES; i++, m <<= 9)
+	{
+		bit = m >> 55;
+		if( !(b->word[bit>>6] & (1ULL<<(bit&63))) )
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Called before the node of hash is written, so a lookup finding the node also passes the filter.
+ * filterBuild is read first: once it is seen cleared, filter is already the rebuilt buffer.
+ */
+static inline void HashFilterAdd(struct hashTable *htbl, unsigned int hash)
+{
+	struct HashFilterBlock *build = NULL;
+	struct HashFilterBlock *filter = NULL;
+
+	if( !htbl->filterMem )
+	{
+		return;
+	}
+	ListOnline(htbl);
+	build = htbl->filterBuild;
+	rte_smp_rmb();
+	filter = htbl->filter;
+	FilterSet(htbl, filter, hash);
+	if( build && build != filter )
+	{
+		FilterSet(htbl, build, hash);
+	}
+}
+
+/*a node moved by an insert may jump over the rebuild scan, it is added to the buffer being built*/
+static inline void HashFilterMove(struct hashTable *htbl, unsigned int hash)
+{
+	struct HashFilterBlock *build = htbl->filterBuild;
+
+	if( unlikely(build != NULL) )
+	{
+		FilterSet(htbl, build, hash);
+	}
+}
+
+/*the key is certainly not in the table*/
+static inline int HashFilterMiss(struct hashTable *htbl, unsigned int hash)
+{
+	if( !htbl->filterMem || FilterTest(htbl, htbl->filter, hash) )
+	{
+		return 0;
+	}
+	HASH_STAT_INC(htbl, miss);
+	HASH_STAT_INC(htbl, filtered);
+	return 1;
+}
+
+static inline void HashFilterPrefetch(struct hashTable *htbl, unsigned int hash)
+{
+	if( htbl->filterMem )
+	{
+		rte_prefetch0(&htbl->filter[hash & htbl->filterMask]);
+	}
+}
+
+static int FilterVisit(void *key, __rte_unused void *value, __rte_unused uint64_t expired, void *userData)
+{
+	struct hashTable *htbl = userData;
+
+	FilterSet(htbl, htbl->filterBuild, htbl->ops.keyHashFunc(key));
+	return 0;
+}
+
+/*
+ * A Bloom filter can not forget the nodes which expired or were deleted, so it is rebuilt into the
+ * spare buffer once the table has seen HASH_FILTER_REBUILD_PERCENT of its capacity of inserts:
+ *  1. the spare buffer is cleared a few blocks per call, after the readers of the last swap are gone
+ *  2. it is published to the inserts, then the table is scanned once the inserts which did not see
+ *     it are done, a few slots per call
+ *  3. the buffers are swapped, the old filter becomes the spare one
+ * A list resize restarts the scan, the nodes it migrates might be behind the scan cursor.
+ */
+static void FilterMaintain(struct hashTable *htbl)
+{
+	unsigned int slots = 0;
+	unsigned int end = 0;
+
+	if( !htbl->filterMem || !rte_spinlock_trylock(&htbl->filterLock) )
+	{
+		return;
+	}
+
+	switch( htbl->filterState )
+	{
+		case HASH_FILTER_IDLE:
+			if( HashQuiescent(htbl, htbl->filterEpoch) &&
+					HashStatInserted(htbl) - htbl->filterInserted >= (uint64_t)htbl->capacity*HASH_FILTER_REBUILD_PERCENT/100 )
+			{
+				htbl->filterCursor = 0;
+				htbl->filterState = HASH_FILTER_CLEAR;
+			}
+			break;
+		case HASH_FILTER_CLEAR:
+			end = RTE_MIN(htbl->filterCursor + HASH_FILTER_CLEAR_STEP, htbl->filterMask + 1);
+			memset(&htbl->filterSpare[htbl->filterCursor], 0x00, sizeof(struct HashFilterBlock)*(end - htbl->filterCursor));
+			htbl->filterCursor = end;
+			if( end == htbl->filterMask + 1 )
+			{
+				htbl->filterInserted = HashStatInserted(htbl);
+				rte_smp_wmb();
+				htbl->filterBuild = htbl->filterSpare;
+				rte_smp_wmb();
+				htbl->filterEpoch = HashNextEpoch(htbl);
+				htbl->filterState = HASH_FILTER_PUBLISHED;
+			}
+			break;
+		case HASH_FILTER_PUBLISHED:
+			if( HashQuiescent(htbl, htbl->filterEpoch) )
+			{
+				htbl->filterCursor = 0;
+				htbl->filterList = htbl->list;
+				htbl->filterState = HASH_FILTER_SCAN;
+			}
+			break;
+		case HASH_FILTER_SCAN:
+			if( htbl->old || htbl->list != htbl->filterList )
+			{
+				htbl->filterCursor = 0;
+				htbl->filterList = htbl->list;
+				break;
+			}
+			slots = hash_table_slots(htbl);
+			end = RTE_MIN(htbl->filterCursor + HASH_FILTER_SCAN_STEP, slots);
+			htbl->inf->iterate(htbl, htbl->filterCursor, end, FilterVisit, htbl, &htbl->filterCursor);
+			if( htbl->filterCursor >= slots )
+			{
+				htbl->filterSpare = htbl->filter;
+				htbl->filter = htbl->filterBuild;
+				rte_smp_wmb();
+				htbl->filterBuild = NULL;
+				htbl->filterEpoch = HashNextEpoch(htbl);
+				htbl->filterState = HASH_FILTER_IDLE;
+			}
+			break;
+	}
+
+	rte_spinlock_unlock(&htbl->filterLock);
+}
+
+static int InitSketch(struct hashTable *htbl, unsigned int capacity)
+{
+	unsigned int count = 0;
+
+	count = ((uint64_t)capacity*HASH_SKETCH_COUNTERS_PER_KEY + 15)/16;
+	count = rte_align32pow2(count > 1 ? count : 2);
+	htbl->sketch = HashMalloc(htbl, sizeof(uint64_t)*count);
+	if( !htbl->sketch )
+	{
+		return -1;
+	}
+	memset((void*)(uintptr_t)htbl->sketch, 0x00, sizeof(uint64_t)*count);
+	htbl->sketchMask = count - 1;
+	htbl->sketchPeriod = (uint64_t)capacity*HASH_SKETCH_SAMPLE_FACTOR;
+	rte_atomic64_init(&htbl->sketchSamples);
+	rte_spinlock_init(&htbl->sketchLock);
+	htbl->st.totalMem += sizeof(uint64_t)*count;
+
+	return 0;
+}
+
+static void ReleaseSketch(struct hashTable *htbl)
+{
+	if( htbl->sketch )
+	{
+		htbl->ops.freeFunc((void*)(uintptr_t)htbl->sketch, sizeof(uint64_t)*(htbl->sketchMask+1));
+	}
+}
+
+/*each row remixes the hash with its own odd multiplier, the high half picks the word and the nibble*/
+static const uint64_t gSketchSeed[HASH_SKETCH_DEPTH] =
+{
+	0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL
+};
+
+static inline volatile uint64_t *SketchWord(struct hashTable *htbl, unsigned int hash, int row, unsigned int *shift)
+{
+	uint64_t m = (uint64_t)hash*gSketchSeed[row];
+
+	*shift = ((m >> 28) & 15)*4;
+	return &htbl->sketch[(m >> 32) & htbl->sketchMask];
+}
+
+/*
+ * Count an access to the key. A counter is bumped by one compare-and-swap of its word, lost to a
+ * concurrent writer of the same word rather than retried: the sketch is an estimate anyway and
+ * the lookups never wait on each other.
+ */
+static void SketchRecord(struct hashTable *htbl, unsigned int hash)
+{
+	struct HashLcoreStats *st = NULL;
+	volatile uint64_t *w = NULL;
+	uint64_t cur = 0;
+	unsigned int shift = 0;
+	int row = 0;
+
+	if( !htbl->sketch )
+	{
+		return;
+	}
+
+	for( ; row < HASH_SKETCH_DEPTH; row++)
+	{
+		w = SketchWord(htbl, hash, row, &shift);
+		cur = *w;
+		if( ((cur >> shift) & 15) < HASH_SKETCH_COUNTER_MAX )
+		{
+			__sync_bool_compare_and_swap(w, cur, cur + (1ULL << shift));
+		}
+	}
+
+	st = HashStats(htbl);
+	if( (++st->sketched & (HASH_SKETCH_BATCH-1)) == 0 )
+	{
+		rte_atomic64_add(&htbl->sketchSamples, HASH_SKETCH_BATCH);
+	}
+}
+
+static unsigned int SketchEstimate(struct hashTable *htbl, unsigned int hash)
+{
+	unsigned int freq = HASH_SKETCH_COUNTER_MAX;
+	unsigned int shift = 0;
+	int row = 0;
+
+	for( ; row < HASH_SKETCH_DEPTH; row++)
+	{
+		freq = RTE_MIN(freq, (unsigned int)((*SketchWord(htbl, hash, row, &shift) >> shift) & 15));
+	}
+
+	return freq;
+}
+
+/*a new key only takes the slot of a live node seen less often than itself*/
+static inline int SketchAdmit(struct hashTable *htbl, unsigned int hash, unsigned int victimHash)
+{
+	if( !htbl->sketch || SketchEstimate(htbl, hash) > SketchEstimate(htbl, victimHash) )
+	{
+		return 1;
+	}
+	HASH_STAT_INC(htbl, rejected);
+
+	return 0;
+}
+
+/*halve every counter once per period, so the frequencies follow the recent accesses*/
+static void SketchMaintain(struct hashTable *htbl)
+{
+	unsigned int end = 0;
+	unsigned int i = 0;
+	uint64_t cur = 0;
+
+	if( !htbl->sketch || (!htbl->sketchCursor && (uint64_t)rte_atomic64_read(&htbl->sketchSamples) < htbl->sketchPeriod) ||
+			!rte_spinlock_trylock(&htbl->sketchLock) )
+	{
+		return;
+	}
+
+	end = RTE_MIN(htbl->sketchCursor + HASH_SKETCH_AGE_STEP, htbl->sketchMask + 1);
+	for( i = htbl->sketchCursor; i < end; i++)
+	{
+		do
+		{
+			cur = htbl->sketch[i];
+		} while( !__sync_bool_compare_and_swap(&htbl->sketch[i], cur, (cur >> 1) & HASH_SKETCH_HALF) );
+	}
+	htbl->sketchCursor = end;
+	if( end == htbl->sketchMask + 1 )
+	{
+		htbl->sketchCursor = 0;
+		rte_atomic64_sub(&htbl->sketchSamples, htbl->sketchPeriod);
+	}
+
+	rte_spinlock_unlock(&htbl->sketchLock);
+}
+
+/*
+ * Load the current array and the array being migrated from. list is published after old when
+ * a resize starts, so whoever sees the new array also sees the old one.
+ */
+static inline struct ListArray *ListArrays(struct hashTable *htbl, struct ListArray **old)
+{
+	struct ListArray *cur = NULL;
+
+	ListOnline(htbl);
+	cur = htbl->list;
+	rte_smp_rmb();
+	*old = htbl->old;
+	if( *old == cur )
+	{
+		*old = NULL;
+	}
+	return cur;
+}
+
+/*LRU uses timeout as its access time, the nodes of the other list strategies expire*/
+static inline int ListExpires(struct hashTable *htbl)
+{
+	return htbl->mode != HASH_STRATEGY_LRU;
+}
+
+static inline unsigned int ListIpHeadOf(struct ListArray *arr, uint32_t ip)
+{
+	return ((uint64_t)((ip >> 8)*HASH_IP_MUL)*arr->ipHeads) >> 32;
+}
+
+/*chain a slot under the address of its key, the slot must be write-locked*/
+static void ListIpLink(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem)
+{
+	uint32_t idx = elem - arr->elem;
+	uint32_t ip = htbl->ops.keyIpFunc(elem->key);
+	unsigned int head = 0;
+
+	if( !ip )
+	{
+		return;
+	}
+	head = ListIpHeadOf(arr, ip);
+	HashSpinLock(htbl, &arr->ipLock[head]);
+	arr->ipOf[idx] = ip;
+	arr->ipPrev[idx] = HASH_IP_NONE;
+	arr->ipNext[idx] = arr->ipHead[head];
+	if( arr->ipHead[head] != HASH_IP_NONE )
+	{
+		arr->ipPrev[arr->ipHead[head]] = idx;
+	}
+	arr->ipHead[head] = idx;
+	HashSpinUnlock(htbl, &arr->ipLock[head]);
+}
+
+static void ListIpUnlink(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem)
+{
+	uint32_t idx = elem - arr->elem;
+	unsigned int head = 0;
+
+	if( !arr->ipOf[idx] )
+	{
+		return;
+	}
+	head = ListIpHeadOf(arr, arr->ipOf[idx]);
+	HashSpinLock(htbl, &arr->ipLock[head]);
+	if( arr->ipPrev[idx] != HASH_IP_NONE )
+	{
+		arr->ipNext[arr->ipPrev[idx]] = arr->ipNext[idx];
+	}
+	else
+	{
+		arr->ipHead[head] = arr->ipNext[idx];
+	}
+	if( arr->ipNext[idx] != HASH_IP_NONE )
+	{
+		arr->ipPrev[arr->ipNext[idx]] = arr->ipPrev[idx];
+	}
+	arr->ipOf[idx] = 0;
+	HashSpinUnlock(htbl, &arr->ipLock[head]);
+}
+
+/*a node overwritten in place with another key moves to the chain of its new address*/
+static inline void ListIpRetag(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem)
+{
+	if( arr->ipOf && arr->ipOf[elem - arr->elem] != htbl->ops.keyIpFunc(elem->key) )
+	{
+		ListIpUnlink(htbl, arr, elem);
+		ListIpLink(htbl, arr, elem);
+	}
+}
+
+/*every status change of a list slot goes through here, the slot must be write-locked*/
+static inline void ListSetStatus(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem, unsigned int status)
+{
+	if( arr->ipOf && status != STATUS_USE )
+	{
+		ListIpUnlink(htbl, arr, elem);
+	}
+	elem->status = status;
+	if( arr->meta )
+	{
+		arr->meta[elem - arr->elem] = status;
+	}
+	if( arr->ipOf && status == STATUS_USE )
+	{
+		ListIpLink(htbl, arr, elem);
+	}
+}
+
+/*the tick never runs past the timeout, an expiry beyond the horizon is stored as the horizon*/
+static inline void ListNoteTick(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem, uint64_t current)
+{
+	arr->tick[elem - arr->elem] = HashTickOf(htbl, RTE_MIN(elem->timeout, current + ((uint64_t)HASH_TICK_HORIZON << htbl->tickShift)));
+}
+
+static inline void ListNoteExpire(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem)
+{
+	if( ListExpires(htbl) )
+	{
+		if( arr->tick )
+		{
+			ListNoteTick(htbl, arr, elem, rte_rdtsc());
+		}
+		HashNoteExpire(arr->expire, elem - arr->elem, elem->timeout);
+	}
+}
+
+/*owner set by hash_table_set_owner for the inserts of this thread*/
+static __thread unsigned int tHashOwner = LCORE_ID_ANY;
+
+/*lcore owning the objects inserted by the calling thread*/
+static inline unsigned int HashOwner(void)
+{
+	return (tHashOwner != LCORE_ID_ANY)?tHashOwner:rte_lcore_id();
+}
+
+static inline uint16_t ListOwnerOf(unsigned int lcore)
+{
+	return (lcore < RTE_MAX_LCORE)?lcore:HASH_OWNER_NONE;
+}
+
+static inline unsigned int ListOwner(struct ListElem *elem)
+{
+	return (elem->owner != HASH_OWNER_NONE)?elem->owner:LCORE_ID_ANY;
+}
+
+static inline void HashExpireNode(struct hashTable *htbl, void *key, void *value, unsigned int owner)
+{
+	if( htbl->ops.evictFunc )
+	{
+		htbl->ops.evictFunc(key, value, owner);
+	}
+	else if( htbl->ops.expireFunc )
+	{
+		htbl->ops.expireFunc(key, value);
+	}
+}
+
+/*
+ * Probe chains run from the home slot to the first free slot, so a lookup stops there. Deleted
+ * and expired nodes leave a tombstone instead, which becomes free once the slot behind it is.
+ */
+static void ListBury(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem)
+{
+	struct ListElem *next = elem + 1;
+
+	ListSetStatus(htbl, arr, elem, STATUS_DELETED);
+	if( next < arr->elem + arr->total )
+	{
+		HashReadLock(htbl, &next->rwlock);
+		if( next->status == STATUS_AVAILABLE )
+		{
+			ListSetStatus(htbl, arr, elem, STATUS_AVAILABLE);
+		}
+		HashReadUnlock(htbl, &next->rwlock);
+	}
+}
+
+/*free the tombstones in front of a slot which just became free, the slot must not be locked*/
+static void ListFreeTombstones(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem)
+{
+	int count = 0;
+
+	for( ; count < htbl->probeStep && elem > arr->elem; count++)
+	{
+		elem--;
+		HashWriteLock(htbl, &elem->rwlock);
+		if( elem->status != STATUS_DELETED )
+		{
+			HashWriteUnlock(htbl, &elem->rwlock);
+			break;
+		}
+		ListBury(htbl, arr, elem);
+		if( elem->status != STATUS_AVAILABLE )
+		{
+			HashWriteUnlock(htbl, &elem->rwlock);
+			break;
+		}
+		HashWriteUnlock(htbl, &elem->rwlock);
+	}
+}
+
+/*copy a node of the old array into the current one, a newer node of the same key wins*/
+static void ListPlace(struct hashTable *htbl, struct ListArray *arr, struct ListElem *src)
+{
+	struct ListElem *elem = &arr->elem[src->hash%arr->size];
+	struct ListElem *reuse = NULL;
+	int count = 0;
+
+	for( ; count < htbl->probeStep; count++, elem++)
+	{
+		HashWriteLock(htbl, &elem->rwlock);
+		if( elem->status == STATUS_AVAILABLE )
+		{
+			HashWriteUnlock(htbl, &elem->rwlock);
+			reuse = reuse?reuse:elem;
+			break;
+		}
+		if( elem->status == STATUS_USE && htbl->ops.cmp(elem->key, src->key) )
+		{
+			HashWriteUnlock(htbl, &elem->rwlock);
+			return;
+		}
+		if( elem->status == STATUS_DELETED && !reuse )
+		{
+			reuse = elem;
+		}
+		HashWriteUnlock(htbl, &elem->rwlock);
+	}
+
+	if( reuse )
+	{
+		HashWriteLock(htbl, &reuse->rwlock);
+		if( reuse->status == STATUS_AVAILABLE || reuse->status == STATUS_DELETED )
+		{
+			reuse->key = src->key;
+			reuse->value = src->value;
+			reuse->timeout = src->timeout;
+			reuse->hash = src->hash;
+			reuse->ref = src->ref;
+			reuse->owner = src->owner;
+			ListSetStatus(htbl, arr, reuse, STATUS_USE);
+			ListNoteExpire(htbl, arr, reuse);
+			HashWriteUnlock(htbl, &reuse->rwlock);
+			return;
+		}
+		HashWriteUnlock(htbl, &reuse->rwlock);
+	}
+	/*no slot left in the window, the node is dropped and its objects are given back*/
+	HASH_STAT_INC(htbl, failed);
+	HashExpireNode(htbl, src->key, src->value, ListOwner(src));
+}
+
+static void ListMigrateSlot(struct hashTable *htbl, struct ListArray *old, unsigned int idx)
+{
+	struct ListElem *elem = &old->elem[idx];
+
+	HashWriteLock(htbl, &elem->rwlock);
+	if( elem->status == STATUS_USE )
+	{
+		/*an expired node is reclaimed instead of being moved*/
+		if( ListExpires(htbl) && rte_rdtsc() >= elem->timeout )
+		{
+			HASH_STAT_INC(htbl, expiration);
+			HashExpireNode(htbl, elem->key, elem->value, ListOwner(elem));
+		}
+		else
+		{
+			ListPlace(htbl, htbl->list, elem);
+		}
+	}
+	ListSetStatus(htbl, old, elem, STATUS_MIGRATED);
+	HashWriteUnlock(htbl, &elem->rwlock);
+}
+
+static void ListFinishResize(struct hashTable *htbl, struct ListArray *old)
+{
+	HashSpinLock(htbl, &htbl->resizeLock);
+	htbl->old = NULL;
+	htbl->retired = old;
+	rte_smp_wmb();
+	htbl->retireEpoch = ++htbl->epoch;
+	HashSpinUnlock(htbl, &htbl->resizeLock);
+}
+
+/*claim the next count slots of the migration cursor and move them*/
+static void ListMigrateStep(struct hashTable *htbl, struct ListArray *old, unsigned int count)
+{
+	unsigned int start = 0;
+	unsigned int end = 0;
+	unsigned int i = 0;
+
+	start = rte_atomic32_add_return(&old->cursor, count) - count;
+	if( start >= old->total )
+	{
+		return;
+	}
+	end = RTE_MIN(start+count, old->total);
+	for( i = start; i < end; i++)
+	{
+		ListMigrateSlot(htbl, old, i);
+	}
+	if( (unsigned int)rte_atomic32_add_return(&old->migrated, end-start) == old->total )
+	{
+		ListFinishResize(htbl, old);
+	}
+}
+
+/*
+ * Before a key is written to the current array its probe window in the old array is migrated,
+ * so a key never lives in both arrays. Each insert also moves a few slots of the cursor.
+ */
+static void ListPrepareInsert(struct hashTable *htbl, unsigned int hash)
+{
+	struct ListArray *old = NULL;
+	unsigned int idx = 0;
+	int count = 0;
+
+	ListArrays(htbl, &old);
+	if( !old )
+	{
+		return;
+	}
+	idx = hash%old->size;
+	for( ; count <= htbl->probeStep; count++)
+	{
+		ListMigrateSlot(htbl, old, idx+count);
+	}
+	ListMigrateStep(htbl, old, HASH_MIGRATE_STEP);
+}
+
+static struct ListElem *ListSearch(struct hashTable *htbl, struct ListArray *arr, unsigned int hash, void *key, struct HashNodeCopy *cp, uint64_t currentTime, int *probes)
+{
+	struct ListElem *elem = &arr->elem[hash%arr->size];
+	int count = 0;
+
+	while( count <= htbl->probeStep )
+	{
+		HashReadLock(htbl, &elem->rwlock);
+		/*the chain of the key ends at the first free slot*/
+		if( elem->status == STATUS_AVAILABLE )
+		{
+			HashReadUnlock(htbl, &elem->rwlock);
+			break;
+		}
+		if( (elem->status == STATUS_USE) && 
+				(htbl->ops.cmp(elem->key, key) == 1) &&
+				(!ListExpires(htbl) || currentTime < elem->timeout) )
+		{
+			if( cp && cp->value )
+			{
+				htbl->ops.assignValue(elem->value, cp->value);
+				cp->expired = elem->timeout;
+			}
+			if( htbl->mode == HASH_STRATEGY_LRU )
+			{
+				elem->timeout = currentTime;
+			}
+			/*only the first hit after the hand passed dirties the line*/
+			else if( htbl->mode == HASH_STRATEGY_CLOCK && !elem->ref )
+			{
+				elem->ref = 1;
+			}
+			HashReadUnlock(htbl, &elem->rwlock);
+			*probes += count + 1;
+			return elem;
+		}
+		HashReadUnlock(htbl, &elem->rwlock);
+
+		elem++;
+		count++;
+	}
+	*probes += RTE_MIN(count + 1, htbl->probeStep + 1);
+
+	return NULL;
+}
+
+/*nodes not migrated yet are still in the old array, a migrated one is already in the current array*/
+static void *ListFind(struct hashTable *htbl, unsigned int hash, void *key, void *copy, struct UpdateCallBack *callback)
+{
+	struct ListArray *cur = NULL;
+	struct ListArray *old = NULL;
+	struct ListElem *elem = NULL;
+	uint64_t currentTime = 0;
+	int probes = 0;
+
+	currentTime = rte_rdtsc();
+	SketchRecord(htbl, hash);
+	cur = ListArrays(htbl, &old);
+	if( old )
+	{
+		elem = ListSearch(htbl, old, hash, key, (struct HashNodeCopy*)copy, currentTime, &probes);
+	}
+	if( !elem )
+	{
+		elem = ListSearch(htbl, cur, hash, key, (struct HashNodeCopy*)copy, currentTime, &probes);
+	}
+	HashStatLookup(htbl, elem != NULL, probes);
+
+	if( callback && callback->update && elem )
+	{
+		HashWriteLock(htbl, &elem->rwlock);
+		/*the slot was unlocked meanwhile, its node may have been deleted, evicted or given to another key*/
+		if( elem->status == STATUS_USE && htbl->ops.cmp(elem->key, key) == 1 )
+		{
+			callback->update(elem->value, callback->userData);
+			HashWriteUnlock(htbl, &elem->rwlock);
+		}
+		else
+		{
+			HashWriteUnlock(htbl, &elem->rwlock);
+			elem = NULL;
+		}
+	}
+	return (elem?elem->value:NULL);
+}
+
+/*
+ * Write a node to the slot chosen by an insert. The slot was unlocked after it was chosen so it
+ * is checked again: a free slot takes the node, a used one is overwritten if still evictable.
+ * The slot must be write-locked.
+ */
+static int ListClaimLocked(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem, unsigned int hash, void *key, void *value, uint64_t timeout, int evict)
+{
+	int ret = RET_FAILED;
+
+	if( elem->status == STATUS_AVAILABLE || elem->status == STATUS_DELETED )
+	{
+		elem->key = key;
+		elem->value = value;
+		elem->owner = ListOwnerOf(HashOwner());
+		ListSetStatus(htbl, arr, elem, STATUS_USE);
+		ret = RET_NEW;
+	}
+	else if( elem->status == STATUS_USE && ListExpires(htbl) && rte_rdtsc() >= elem->timeout )
+	{
+		htbl->ops.assignKey(key, elem->key);
+		htbl->ops.assignValue(value, elem->value);
+		HASH_STAT_INC(htbl, expiration);
+		ret = RET_OCCUPY;
+	}
+	else if( elem->status == STATUS_USE && evict )
+	{
+		htbl->ops.assignKey(key, elem->key);
+		htbl->ops.assignValue(value, elem->value);
+		HASH_STAT_INC(htbl, eviction);
+		ret = RET_OCCUPY;
+	}
+	if( ret != RET_FAILED )
+	{
+		elem->timeout = timeout;
+		elem->hash = hash;
+		elem->ref = 0;
+		ListNoteExpire(htbl, arr, elem);
+		ListIpRetag(htbl, arr, elem);
+	}
+
+	return ret;
+}
+
+static int ListClaim(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem, unsigned int hash, void *key, void *value, uint64_t timeout, int evict)
+{
+	int ret = RET_FAILED;
+
+	HashWriteLock(htbl, &elem->rwlock);
+	ret = ListClaimLocked(htbl, arr, elem, hash, key, value, timeout, evict);
+	HashWriteUnlock(htbl, &elem->rwlock);
+
+	return ret;
+}
+
+/*
+ * The probe chain is walked up to the first free slot looking for the key. A new key takes the
+ * first tombstone, expired node or free slot of the chain. When there is none, LRU evicts the
+ * node with the oldest access time and CLOCK clears the reference bits it passes and evicts the
+ * first node not referenced since, or the home slot if all were. Self-expired inserts fail.
+ */
+static int ListInsert(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout)
+{
+	struct ListArray *arr = NULL;
+	struct ListElem *elem = NULL;
+	struct ListElem *reuse = NULL;
+	struct ListElem *victim = NULL;
+	uint64_t currentTime = 0;
+	int count = 0;
+	int ret = RET_FAILED;
+	int retry = 0;
+
+	currentTime = rte_rdtsc();
+	SketchRecord(htbl, hash);
+	ListPrepareInsert(htbl, hash);
+
+AGAIN:
+	arr = htbl->list;
+	elem = &arr->elem[hash%arr->size];
+	reuse = NULL;
+	victim = NULL;
+	count = 0;
+
+	while( count < htbl->probeStep )
+	{
+		HashWriteLock(htbl, &elem->rwlock);
+		if( elem->status == STATUS_AVAILABLE )
+		{
+			HashWriteUnlock(htbl, &elem->rwlock);
+			reuse = reuse?reuse:elem;
+			break;
+		}
+
+		if( (elem->status == STATUS_USE) && htbl->ops.cmp(elem->key, key) )
+		{
+			htbl->ops.assignKey(key, elem->key);
+			htbl->ops.assignValue(value, elem->value);
+			/*rewriting a live key counts as an access*/
+			elem->ref = (htbl->mode == HASH_STRATEGY_CLOCK && currentTime < elem->timeout);
+			elem->timeout = timeout;
+			elem->hash = hash;
+			ListNoteExpire(htbl, arr, elem);
+			ListIpRetag(htbl, arr, elem);
+			HashWriteUnlock(htbl, &elem->rwlock);
+			return RET_OCCUPY;
+		}
+		/*a resize started after the array was loaded*/
+		if( elem->status == STATUS_MIGRATED && !retry++ )
+		{
+			HashWriteUnlock(htbl, &elem->rwlock);
+			ListPrepareInsert(htbl, hash);
+			goto AGAIN;
+		}
+
+		if( !reuse && (elem->status == STATUS_DELETED ||
+					(elem->status == STATUS_USE && ListExpires(htbl) && currentTime >= elem->timeout)) )
+		{
+			reuse = elem;
+		}
+		else if( !reuse && elem->status == STATUS_USE )
+		{
+			if( htbl->mode == HASH_STRATEGY_LRU && (!victim || elem->timeout < victim->timeout) )
+			{
+				victim = elem;
+			}
+			else if( htbl->mode == HASH_STRATEGY_CLOCK && !victim )
+			{
+				if( elem->ref )
+				{
+					elem->ref = 0;
+				}
+				else
+				{
+					victim = elem;
+				}
+			}
+		}
+		HashWriteUnlock(htbl, &elem->rwlock);
+
+		elem++;
+		count++;
+		HASH_STAT_INC(htbl, collision);
+	}
+
+	if( reuse )
+	{
+		ret = ListClaim(htbl, arr, reuse, hash, key, value, timeout, 0);
+	}
+	else if( htbl->mode != HASH_STRATEGY_SELF_EXPIRED )
+	{
+		victim = victim?victim:&arr->elem[hash%arr->size];
+		if( SketchAdmit(htbl, hash, victim->hash) )
+		{
+			ret = ListClaim(htbl, arr, victim, hash, key, value, timeout, 1);
+		}
+	}
+
+	if( ret == RET_FAILED )
+	{
+		HASH_STAT_INC(htbl, failed);
+	}
+
+	return ret;
+}
+
+/*
+ * The same walk as ListInsert, but the home slot stays write-locked until the node is written so
+ * the upserts of a key are serialized on it. Slots are locked in increasing order, the home slot
+ * and at most one other at a time.
+ */
+static int ListUpsert(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout, struct UpsertCallBack *callback, struct HashNodeCopy *cp)
+{
+	struct ListArray *arr = NULL;
+	struct ListElem *home = NULL;
+	struct ListElem *elem = NULL;
+	struct ListElem *reuse = NULL;
+	struct ListElem *victim = NULL;
+	uint64_t currentTime = 0;
+	int count = 0;
+	int stop = 0;
+	int ret = RET_FAILED;
+	int retry = 0;
+	int lost = 0;
+
+	currentTime = rte_rdtsc();
+	SketchRecord(htbl, hash);
+	ListPrepareInsert(htbl, hash);
+
+AGAIN:
+	arr = htbl->list;
+	home = &arr->elem[hash%arr->size];
+	elem = home;
+	reuse = NULL;
+	victim = NULL;
+	count = 0;
+	stop = 0;
+
+	HashWriteLock(htbl, &home->rwlock);
+	while( count < htbl->probeStep )
+	{
+		if( elem != home )
+		{
+			HashWriteLock(htbl, &elem->rwlock);
+		}
+		/*a resize started after the array was loaded*/
+		if( elem->status == STATUS_MIGRATED && !retry++ )
+		{
+			if( elem != home )
+			{
+				HashWriteUnlock(htbl, &elem->rwlock);
+			}
+			HashWriteUnlock(htbl, &home->rwlock);
+			ListPrepareInsert(htbl, hash);
+			goto AGAIN;
+		}
+		if( elem->status == STATUS_AVAILABLE )
+		{
+			reuse = reuse?reuse:elem;
+			stop = 1;
+		}
+		else if( (elem->status == STATUS_USE) && htbl->ops.cmp(elem->key, key) )
+		{
+			if( !ListExpires(htbl) || currentTime < elem->timeout )
+			{
+				if( callback && callback->update )
+				{
+					callback->update(elem->value, callback->userData);
+				}
+				if( htbl->mode == HASH_STRATEGY_LRU )
+				{
+					elem->timeout = currentTime;
+				}
+				else if( htbl->mode == HASH_STRATEGY_CLOCK && !elem->ref )
+				{
+					elem->ref = 1;
+				}
+				if( cp && cp->value )
+				{
+					htbl->ops.assignValue(elem->value, cp->value);
+					cp->expired = elem->timeout;
+				}
+				ret = RET_UPDATE;
+			}
+			/*the expired node of the key is taken over*/
+			reuse = elem;
+			stop = 1;
+		}
+		else if( !reuse && (elem->status == STATUS_DELETED ||
+					(elem->status == STATUS_USE && ListExpires(htbl) && currentTime >= elem->timeout)) )
+		{
+			reuse = elem;
+		}
+		else if( !reuse && elem->status == STATUS_USE )
+		{
+			if( htbl->mode == HASH_STRATEGY_LRU && (!victim || elem->timeout < victim->timeout) )
+			{
+				victim = elem;
+			}
+			else if( htbl->mode == HASH_STRATEGY_CLOCK && !victim )
+			{
+				if( elem->ref )
+				{
+					elem->ref = 0;
+				}
+				else
+				{
+					victim = elem;
+				}
+			}
+		}
+		if( elem != home )
+		{
+			HashWriteUnlock(htbl, &elem->rwlock);
+		}
+		if( stop )
+		{
+			break;
+		}
+
+		elem++;
+		count++;
+		HASH_STAT_INC(htbl, collision);
+	}
+	if( ret == RET_UPDATE )
+	{
+		goto DONE;
+	}
+
+	if( !reuse && htbl->mode != HASH_STRATEGY_SELF_EXPIRED )
+	{
+		victim = victim?victim:home;
+		victim = SketchAdmit(htbl, hash, victim->hash)?victim:NULL;
+	}
+	elem = reuse?reuse:victim;
+	if( elem )
+	{
+		if( callback && callback->init )
+		{
+			callback->init(value, callback->userData);
+		}
+		if( elem != home )
+		{
+			HashWriteLock(htbl, &elem->rwlock);
+		}
+		ret = ListClaimLocked(htbl, arr, elem, hash, key, value, timeout, reuse == NULL);
+		if( ret != RET_FAILED && cp && cp->value )
+		{
+			htbl->ops.assignValue(elem->value, cp->value);
+			cp->expired = elem->timeout;
+		}
+		if( elem != home )
+		{
+			HashWriteUnlock(htbl, &elem->rwlock);
+		}
+		/*a plain insert of another key took the free slot while it was unlocked, walk the window again*/
+		if( ret == RET_FAILED && reuse && lost++ < htbl->probeStep )
+		{
+			HashWriteUnlock(htbl, &home->rwlock);
+			goto AGAIN;
+		}
+	}
+	if( ret == RET_FAILED )
+	{
+		HASH_STAT_INC(htbl, failed);
+	}
+
+DONE:
+	HashWriteUnlock(htbl, &home->rwlock);
+	return ret;
+}
+
+/*
+ * Bury the node of a write-locked slot, unlock the slot and give back the key/value of the node.
+ * Return the owner of the node.
+ */
+static unsigned int ListRemoveLocked(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem)
+{
+	void *nodeKey = elem->key;
+	void *nodeValue = elem->value;
+	unsigned int owner = ListOwner(elem);
+	int freed = 0;
+
+	ListBury(htbl, arr, elem);
+	freed = (elem->status == STATUS_AVAILABLE);
+	if( !freed )
+	{
+		/*have the sweep visit the segment to free the tombstone later*/
+		HashNoteExpire(arr->expire, elem - arr->elem, 0);
+	}
+	HashWriteUnlock(htbl, &elem->rwlock);
+	if( freed )
+	{
+		ListFreeTombstones(htbl, arr, elem);
+	}
+	HashExpireNode(htbl, nodeKey, nodeValue, owner);
+
+	return owner;
+}
+
+/*
+ * The node is removed from the current array, its probe window in the old one is migrated first.
+ * An insert racing with the delete may still land behind the freed slot, the node is then missed
+ * by lookups until it expires as if the insert had failed.
+ */
+static int ListDelete(struct hashTable *htbl, unsigned int hash, void *key, void *copy)
+{
+	struct ListArray *arr = NULL;
+	struct ListElem *elem = NULL;
+	struct HashNodeCopy *cp = NULL;
+	int count = 0;
+
+	cp = (struct HashNodeCopy*)copy;
+	ListPrepareInsert(htbl, hash);
+	arr = htbl->list;
+	elem = &arr->elem[hash%arr->size];
+
+	for( ; count <= htbl->probeStep; count++, elem++)
+	{
+		HashWriteLock(htbl, &elem->rwlock);
+		if( elem->status == STATUS_AVAILABLE )
+		{
+			HashWriteUnlock(htbl, &elem->rwlock);
+			break;
+		}
+		if( elem->status == STATUS_USE && htbl->ops.cmp(elem->key, key) == 1 )
+		{
+			if( cp && cp->value )
+			{
+				htbl->ops.assignValue(elem->value, cp->value);
+				cp->expired = elem->timeout;
+			}
+			ListRemoveLocked(htbl, arr, elem);
+			return 0;
+		}
+		HashWriteUnlock(htbl, &elem->rwlock);
+	}
+
+	return RET_FAILED;
+}
+
+static int ResizeList(struct hashTable *htbl, unsigned int capacity)
+{
+	struct ListArray *arr = NULL;
+	int ret = -1;
+
+	HashSpinLock(htbl, &htbl->resizeLock);
+	/*one migration at a time, and the array retired by the previous one must be released*/
+	if( htbl->old || htbl->retired )
+	{
+		goto DONE;
+	}
+	arr = AllocList(htbl, htbl->factor*capacity);
+	if( !arr )
+	{
+		printf("Malloc bucket for resize failed.\n");
+		goto DONE;
+	}
+	rte_atomic32_set(&htbl->list->cursor, 0);
+	rte_atomic32_set(&htbl->list->migrated, 0);
+	htbl->old = htbl->list;
+	rte_smp_wmb();
+	htbl->list = arr;
+	htbl->bucketSize = arr->size;
+	htbl->capacity = capacity;
+	htbl->st.totalMem = sizeof(*htbl) + ListArraySize(htbl, arr->total) + ListArraySize(htbl, htbl->old->total);
+	ret = 0;
+
+DONE:
+	HashSpinUnlock(htbl, &htbl->resizeLock);
+	return ret;
+}
+
+/*the old array is released once every lcore using the table went through a maintenance call*/
+static void ListReclaimRetired(struct hashTable *htbl)
+{
+	struct ListArray *retired = NULL;
+	unsigned int i = 0;
+
+	if( !htbl->retired )
+	{
+		return;
+	}
+	for( ; i < RTE_MAX_LCORE; i++)
+	{
+		if( htbl->qs[i].online && htbl->qs[i].epoch < htbl->retireEpoch )
+		{
+			return;
+		}
+	}
+
+	HashSpinLock(htbl, &htbl->resizeLock);
+	retired = htbl->retired;
+	htbl->retired = NULL;
+	if( retired )
+	{
+		htbl->st.totalMem = sizeof(*htbl) + ListArraySize(htbl, htbl->list->total);
+	}
+	HashSpinUnlock(htbl, &htbl->resizeLock);
+	FreeList(htbl, retired);
+}
+
+/*estimate the number of used nodes from a window of slots sampled on each maintenance call*/
+static void ListSampleLoad(struct hashTable *htbl)
+{
+	struct ListArray *arr = htbl->list;
+	struct ListMetaScan scan;
+	unsigned int idx = 0;
+	unsigned int n = 0;
+	unsigned int start = 0;
+	unsigned int used = 0;
+	unsigned int i = 0;
+	uint64_t currentTime = rte_rdtsc();
+
+	start = htbl->sampleCursor%arr->size;
+	htbl->sampleCursor = start + HASH_SAMPLE_SLOTS;
+	/*a node expiring within the current tick already counts as expired, it is only an estimate*/
+	for( ; arr->meta && i < HASH_SAMPLE_SLOTS; i += n)
+	{
+		idx = (start+i)%arr->size;
+		n = RTE_MIN(RTE_MIN(arr->size - idx, HASH_SAMPLE_SLOTS - i), HASH_META_SCAN);
+		ListScanMeta(arr, idx, n, HashTickOf(htbl, currentTime), &scan);
+		used += __builtin_popcount(ListExpires(htbl)?scan.used & ~scan.due:scan.used);
+	}
+	for( ; i < HASH_SAMPLE_SLOTS; i++)
+	{
+		struct ListElem *elem = &arr->elem[(start+i)%arr->size];
+		if( elem->status == STATUS_USE && (!ListExpires(htbl) || currentTime < elem->timeout) )
+		{
+			used++;
+		}
+	}
+	used = (uint64_t)used*arr->size/HASH_SAMPLE_SLOTS;
+	htbl->estimateUsed = htbl->estimateUsed ? (htbl->estimateUsed*7 + used)/8 : used;
+}
+
+static void ListAutoResize(struct hashTable *htbl)
+{
+	unsigned int failed = (unsigned int)HashStatFailed(htbl);
+	unsigned int capacity = htbl->capacity;
+
+	ListSampleLoad(htbl);
+	if( failed != htbl->lastFailed || htbl->estimateUsed > (uint64_t)capacity*HASH_GROW_PERCENT/100 )
+	{
+		capacity *= 2;
+	}
+	else if( htbl->estimateUsed < (uint64_t)capacity*HASH_SHRINK_PERCENT/100 )
+	{
+		capacity /= 2;
+	}
+	htbl->lastFailed = failed;
+
+	capacity = RTE_MAX(capacity, htbl->minCapacity);
+	capacity = RTE_MIN(capacity, htbl->maxCapacity);
+	if( capacity != htbl->capacity && ResizeList(htbl, capacity) == 0 )
+	{
+		htbl->estimateUsed = 0;
+	}
+}
+
+static int SweepListSlot(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem, uint64_t current, uint64_t *next)
+{
+	int reclaimed = 0;
+
+	HashWriteLock(htbl, &elem->rwlock);
+	if( elem->status == STATUS_USE && ListExpires(htbl) )
+	{
+		if( current >= elem->timeout )
+		{
+			ListBury(htbl, arr, elem);
+			HashExpireNode(htbl, elem->key, elem->value, ListOwner(elem));
+			reclaimed = 1;
+		}
+		else
+		{
+			*next = RTE_MIN(*next, elem->timeout);
+			/*the tick reached the horizon of a farther timeout*/
+			if( arr->tick )
+			{
+				ListNoteTick(htbl, arr, elem, current);
+			}
+		}
+	}
+	else if( elem->status == STATUS_DELETED )
+	{
+		ListBury(htbl, arr, elem);
+	}
+	HashWriteUnlock(htbl, &elem->rwlock);
+
+	return reclaimed;
+}
+
+/*
+ * Only the tombstones and the nodes whose tick was reached are locked and checked, the earliest
+ * expiry of the other nodes is taken from their ticks, which never run past their timeout.
+ */
+static int SweepListMeta(struct hashTable *htbl, struct ListArray *arr, unsigned int start, unsigned int end, uint64_t current, uint64_t *next)
+{
+	struct ListMetaScan scan;
+	uint32_t now = HashTickOf(htbl, current);
+	uint32_t mask = 0;
+	unsigned int n = 0;
+	int reclaimed = 0;
+	int bit = 0;
+
+	for( ; end > start; end -= n)
+	{
+		n = RTE_MIN(end - start, HASH_META_SCAN);
+		ListScanMeta(arr, end - n, n, now, &scan);
+		if( scan.wait != INT32_MAX && ListExpires(htbl) )
+		{
+			*next = RTE_MIN(*next, ((current >> htbl->tickShift) + scan.wait) << htbl->tickShift);
+		}
+		for( mask = (ListExpires(htbl)?scan.due:0) | scan.deleted; mask; mask &= ~(1U << bit))
+		{
+			bit = 31 - __builtin_clz(mask);
+			reclaimed += SweepListSlot(htbl, arr, &arr->elem[end - n + bit], current, next);
+		}
+	}
+
+	return reclaimed;
+}
+
+/*slots are swept backwards so the tombstones of a chain are freed from its end*/
+static int SweepList(struct hashTable *htbl, void *ctx, unsigned int start, unsigned int end, uint64_t current, uint64_t *next)
+{
+	struct ListArray *arr = (struct ListArray*)ctx;
+	struct ListElem *elem = NULL;
+	unsigned int i = end;
+	int reclaimed = 0;
+
+	if( arr->meta )
+	{
+		return SweepListMeta(htbl, arr, start, end, current, next);
+	}
+	while( i-- > start )
+	{
+		elem = &arr->elem[i];
+		if( elem->status != STATUS_USE && elem->status != STATUS_DELETED )
+		{
+			continue;
+		}
+		reclaimed += SweepListSlot(htbl, arr, elem, current, next);
+	}
+
+	return reclaimed;
+}
+
+/*the old array of a resize is left to the migration, which drops its expired nodes*/
+static int ExpireList(struct hashTable *htbl, unsigned int budget)
+{
+	struct ListArray *old = NULL;
+	struct ListArray *cur = ListArrays(htbl, &old);
+
+	return HashExpireSegments(htbl, cur->expire, cur->total, SweepList, cur, budget);
+}
+
+/*nodes still in the old array of a resize are not visited*/
+static int IterateList(struct hashTable *htbl, unsigned int start, unsigned int end, fpVisit visit, void *userData, unsigned int *next)
+{
+	struct ListArray *old = NULL;
+	struct ListArray *arr = ListArrays(htbl, &old);
+	struct ListElem *elem = NULL;
+	struct ListMetaScan scan;
+	uint64_t currentTime = rte_rdtsc();
+	unsigned int i = start;
+	unsigned int n = 0;
+	int visited = 0;
+	int stop = 0;
+
+	end = RTE_MIN(end, arr->total);
+	while( i < end && !stop )
+	{
+		/*the slots not used are skipped 32 at a time*/
+		if( arr->meta && (n = RTE_MIN(end - i, HASH_META_SCAN)) == HASH_META_SCAN )
+		{
+			ListScanMeta(arr, i, n, 0, &scan);
+			if( !scan.used )
+			{
+				i += n;
+				continue;
+			}
+			i += __builtin_ctz(scan.used);
+		}
+		elem = &arr->elem[i++];
+		if( elem->status != STATUS_USE )
+		{
+			continue;
+		}
+		HashReadLock(htbl, &elem->rwlock);
+		if( elem->status == STATUS_USE && (!ListExpires(htbl) || currentTime < elem->timeout) )
+		{
+			stop = visit(elem->key, elem->value, elem->timeout, userData);
+			visited++;
+		}
+		HashReadUnlock(htbl, &elem->rwlock);
+	}
+	*next = i;
+
+	return visited;
+}
+
+static inline int ListOwnedBy(struct ListElem *elem, unsigned int owner)
+{
+	return owner == LCORE_ID_ANY || ListOwner(elem) == owner;
+}
+
+/*
+ * Give back the node of a slot if it expired, or if evict is set and it is still a node of owner.
+ * Return whether a node of owner was given back.
+ */
+static int ListReclaimSlot(struct hashTable *htbl, struct ListArray *arr, struct ListElem *elem, unsigned int owner, int evict)
+{
+	unsigned int nodeOwner = 0;
+	int expired = 0;
+
+	HashWriteLock(htbl, &elem->rwlock);
+	expired = (elem->status == STATUS_USE && ListExpires(htbl) && rte_rdtsc() >= elem->timeout);
+	if( elem->status != STATUS_USE || (!expired && !(evict && ListOwnedBy(elem, owner))) )
+	{
+		HashWriteUnlock(htbl, &elem->rwlock);
+		return 0;
+	}
+	nodeOwner = ListRemoveLocked(htbl, arr, elem);
+	if( expired )
+	{
+		HASH_STAT_INC(htbl, expiration);
+	}
+	else
+	{
+		HASH_STAT_INC(htbl, eviction);
+	}
+
+	return owner == LCORE_ID_ANY || nodeOwner == owner;
+}
+
+/*
+ * The candidates of a window are picked without locking the slots and checked again under the
+ * lock of the slot. The old array of a resize is left to the migration, as in ExpireList.
+ */
+static int ReclaimList(struct hashTable *htbl, unsigned int owner, unsigned int want, unsigned int budget)
+{
+	struct ListArray *old = NULL;
+	struct ListArray *arr = ListArrays(htbl, &old);
+	struct ListElem *elem = NULL;
+	struct ListElem *victim = NULL;
+	struct ListMetaScan scan;
+	uint64_t currentTime = rte_rdtsc();
+	unsigned int start = 0;
+	unsigned int n = 0;
+	uint32_t mask = 0;
+	int reclaimed = 0;
+	int bit = 0;
+
+	for( ; budget > 0 && reclaimed < (int)want; budget -= RTE_MIN(budget, HASH_META_SCAN))
+	{
+		start = (unsigned int)(rte_atomic32_add_return(&htbl->reclaimCursor, HASH_META_SCAN) - HASH_META_SCAN)%arr->total;
+		n = RTE_MIN(arr->total - start, HASH_META_SCAN);
+		mask = (n == HASH_META_SCAN)?UINT32_MAX:((1U << n) - 1);
+		if( arr->meta )
+		{
+			ListScanMeta(arr, start, n, 0, &scan);
+			mask &= scan.used;
+		}
+
+		/*backwards, so the tombstones left in the window are freed from its end*/
+		victim = NULL;
+		for( ; mask; mask &= ~(1U << bit))
+		{
+			bit = 31 - __builtin_clz(mask);
+			elem = &arr->elem[start + bit];
+			if( elem->status != STATUS_USE )
+			{
+				continue;
+			}
+			if( ListExpires(htbl) && currentTime >= elem->timeout )
+			{
+				reclaimed += ListReclaimSlot(htbl, arr, elem, owner, 0);
+			}
+			else if( ListOwnedBy(elem, owner) )
+			{
+				if( htbl->mode == HASH_STRATEGY_CLOCK && elem->ref )
+				{
+					elem->ref = 0;
+				}
+				else if( !victim || elem->timeout < victim->timeout )
+				{
+					victim = elem;
+				}
+			}
+		}
+		if( victim && reclaimed < (int)want )
+		{
+			reclaimed += ListReclaimSlot(htbl, arr, victim, owner, 1);
+		}
+	}
+
+	return reclaimed;
+}
+
+/*
+ * The slots of a /24 chain matching the prefix are collected HASH_IP_BATCH at a time with the
+ * chain locked, then each is checked again and deleted under the lock of the slot alone.
+ */
+static int ListInvalidateChain(struct hashTable *htbl, struct ListArray *arr, unsigned int head, uint32_t net, uint32_t mask)
+{
+	uint32_t batch[HASH_IP_BATCH];
+	struct ListElem *elem = NULL;
+	uint32_t idx = 0;
+	unsigned int count = 0;
+	unsigned int i = 0;
+	int deleted = 0;
+
+	do
+	{
+		count = 0;
+		HashSpinLock(htbl, &arr->ipLock[head]);
+		for( idx = arr->ipHead[head]; idx != HASH_IP_NONE && count < HASH_IP_BATCH; idx = arr->ipNext[idx])
+		{
+			if( (arr->ipOf[idx] & mask) == net )
+			{
+				batch[count++] = idx;
+			}
+		}
+		HashSpinUnlock(htbl, &arr->ipLock[head]);
+
+		for( i = 0; i < count; i++)
+		{
+			elem = &arr->elem[batch[i]];
+			HashWriteLock(htbl, &elem->rwlock);
+			if( elem->status != STATUS_USE || !arr->ipOf[batch[i]] || (arr->ipOf[batch[i]] & mask) != net )
+			{
+				HashWriteUnlock(htbl, &elem->rwlock);
+				continue;
+			}
+			ListRemoveLocked(htbl, arr, elem);
+			deleted++;
+		}
+	} while( count == HASH_IP_BATCH );
+
+	return deleted;
+}
+
+/*the old array of a resize is walked first, a node migrated meanwhile is found in the current one*/
+static int InvalidateList(struct hashTable *htbl, uint32_t ip, unsigned int prefixLen)
+{
+	struct ListArray *old = NULL;
+	struct ListArray *cur = ListArrays(htbl, &old);
+	struct ListArray *arr[2] = { old, cur };
+	uint32_t mask = prefixLen ? (UINT32_MAX << (32 - prefixLen)) : 0;
+	uint32_t net = ip & mask;
+	uint32_t blocks = (prefixLen >= 24) ? 1 : (1U << (24 - prefixLen));
+	uint32_t block = 0;
+	int deleted = 0;
+	int i = 0;
+
+	for( ; i < 2; i++)
+	{
+		if( !arr[i] )
+		{
+			continue;
+		}
+		/*a head shared by several /24 of the prefix is walked again, finding nothing left*/
+		for( block = 0; block < blocks; block++)
+		{
+			deleted += ListInvalidateChain(htbl, arr[i], ListIpHeadOf(arr[i], net + (block << 8)), net, mask);
+		}
+	}
+	HASH_STAT_ADD(htbl, deletion, deleted);
+
+	return deleted;
+}
+
+static void PrefetchList(struct hashTable *htbl, unsigned int hash, int stage)
+{
+	struct ListArray *arr = htbl->list;
+	struct ListElem *elem = &arr->elem[hash%arr->size];
+
+	if( stage == 0 )
+	{
+		rte_prefetch0(elem);
+		rte_prefetch0(elem + htbl->probeStep);
+	}
+	else if( elem->status == STATUS_USE )
+	{
+		rte_prefetch0(elem->key);
+	}
+}
+
+static void MaintainList(struct hashTable *htbl)
+{
+	struct ListArray *old = NULL;
+
+	ListReclaimRetired(htbl);
+	ListArrays(htbl, &old);
+	if( old )
+	{
+		ListMigrateStep(htbl, old, HASH_MAINTAIN_STEP);
+	}
+	else if( htbl->maxCapacity && !htbl->retired && rte_spinlock_trylock(&htbl->autoLock) )
+	{
+		ListAutoResize(htbl);
+		rte_spinlock_unlock(&htbl->autoLock);
+	}
+}
+
+static inline uint16_t CuckooSig(unsigned int hash)
+{
+	uint16_t sig = hash >> 16;
+
+	return sig?sig:1;
+}
+
+static inline unsigned int CuckooAlt(struct hashTable *htbl, unsigned int bkt, uint16_t sig)
+{
+	return (bkt ^ sig) & htbl->cbucketMask;
+}
+
+/*compare sig against the whole bucket with one instruction, bit i is set when entry i matches*/
+static inline unsigned int CuckooMatch(struct CuckooBucket *b, uint16_t sig)
+{
+#if defined(RTE_MACHINE_CPUFLAG_SSE2)
+	__m128i cmp = _mm_cmpeq_epi16(_mm_loadu_si128((__m128i*)b->sig), _mm_set1_epi16(sig));
+
+	return _mm_movemask_epi8(_mm_packs_epi16(cmp, _mm_setzero_si128()));
+#else
+	unsigned int mask = 0;
+	int i = 0;
+
+	for( ; i < CUCKOO_BUCKET_ENTRIES; i++)
+	{
+		if( b->sig[i] == sig )
+		{
+			mask |= 1<<i;
+		}
+	}
+	return mask;
+#endif
+}
+
+/*compare sig against both candidate buckets at once*/
+static inline void CuckooMatchPair(struct CuckooBucket *prim, struct CuckooBucket *sec, uint16_t sig, unsigned int *primMask, unsigned int *secMask)
+{
+#if defined(RTE_MACHINE_CPUFLAG_AVX2)
+	__m256i sigs = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((__m128i*)prim->sig)), _mm_loadu_si128((__m128i*)sec->sig), 1);
+	__m256i cmp = _mm256_cmpeq_epi16(sigs, _mm256_set1_epi16(sig));
+	unsigned int mask = _mm256_movemask_epi8(_mm256_packs_epi16(cmp, _mm256_setzero_si256()));
+
+	*primMask = mask & 0xff;
+	*secMask = (mask >> 16) & 0xff;
+#else
+	*primMask = CuckooMatch(prim, sig);
+	*secMask = CuckooMatch(sec, sig);
+#endif
+}
+
+static int InitCuckoo(struct hashTable *htbl, int size)
+{
+	unsigned int count = 0;
+	unsigned int i = 0;
+
+	htbl->capacity = size;
+	count = ((uint64_t)size*100/CUCKOO_LOAD_PERCENT + CUCKOO_BUCKET_ENTRIES - 1)/CUCKOO_BUCKET_ENTRIES;
+	count = rte_align32pow2(count > 1 ? count : 2);
+	htbl->cbucketMask = count - 1;
+	htbl->bucketSize = count*CUCKOO_BUCKET_ENTRIES;
+
+	htbl->cbucket = HashMalloc(htbl, sizeof(struct CuckooBucket)*count);
+	htbl->centry = HashMalloc(htbl, sizeof(struct CuckooEntry)*htbl->bucketSize);
+	if( !htbl->cbucket || !htbl->centry )
+	{
+		printf("Malloc cuckoo bucket failed.\n");
+		return -1;
+	}
+	memset(htbl->cbucket, 0x00, sizeof(struct CuckooBucket)*count);
+	memset(htbl->centry, 0x00, sizeof(struct CuckooEntry)*htbl->bucketSize);
+	for( ; i < count; i++)
+	{
+		rte_rwlock_init(&(htbl->cbucket[i].rwlock));
+	}
+	rte_spinlock_init(&htbl->writeLock);
+	htbl->change = 0;
+	htbl->st.totalMem = sizeof(*htbl) + sizeof(struct CuckooBucket)*count + sizeof(struct CuckooEntry)*htbl->bucketSize;
+	if( AllocSegments(htbl, htbl->bucketSize) < 0 )
+	{
+		printf("Malloc expiry segments failed.\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static void ReleaseCuckoo(struct hashTable *htbl)
+{
+	if( htbl->cbucket )
+	{
+		htbl->ops.freeFunc(htbl->cbucket, sizeof(struct CuckooBucket)*(htbl->cbucketMask+1));
+	}
+	if( htbl->centry )
+	{
+		htbl->ops.freeFunc(htbl->centry, sizeof(struct CuckooEntry)*htbl->bucketSize);
+	}
+	FreeSegments(htbl, htbl->bucketSize);
+}
+
+static void TravelCuckoo(struct hashTable *htbl, uint64_t current, int *cnt, int *timeout, int *available)
+{
+	unsigned int i = 0;
+	struct CuckooEntry *entry = NULL;
+
+	for( ; i < htbl->bucketSize; i++)
+	{
+		if( htbl->cbucket[i/CUCKOO_BUCKET_ENTRIES].sig[i%CUCKOO_BUCKET_ENTRIES] == CUCKOO_SIG_EMPTY )
+		{
+			(*available)++;
+			continue;
+		}
+		entry = &htbl->centry[i];
+		(*cnt)++;
+		if( htbl->ops.assessFunc )
+		{
+			htbl->ops.assessFunc(entry->value);
+		}
+		if( entry->timeout < current )
+		{
+			(*timeout)++;
+		}
+	}
+}
+
+/*
+ * Move one entry to an empty slot. The destination is published before the source is cleared,
+ * and change is bumped in between, so a concurrent reader either finds the entry or retries.
+ */
+static void CuckooMove(struct hashTable *htbl, unsigned int srcBkt, int srcSlot, unsigned int dstBkt, int dstSlot)
+{
+	struct CuckooBucket *src = &htbl->cbucket[srcBkt];
+	struct CuckooBucket *dst = &htbl->cbucket[dstBkt];
+
+	if( unlikely(htbl->filterBuild != NULL) )
+	{
+		HashFilterMove(htbl, htbl->ops.keyHashFunc(htbl->centry[srcBkt*CUCKOO_BUCKET_ENTRIES+srcSlot].key));
+	}
+	HashWriteLock(htbl, &dst->rwlock);
+	htbl->centry[dstBkt*CUCKOO_BUCKET_ENTRIES+dstSlot] = htbl->centry[srcBkt*CUCKOO_BUCKET_ENTRIES+srcSlot];
+	dst->sig[dstSlot] = src->sig[srcSlot];
+	HashNoteExpire(htbl->segExpire, dstBkt*CUCKOO_BUCKET_ENTRIES+dstSlot, htbl->centry[dstBkt*CUCKOO_BUCKET_ENTRIES+dstSlot].timeout);
+	HashWriteUnlock(htbl, &dst->rwlock);
+
+	rte_smp_wmb();
+	htbl->change++;
+	rte_smp_wmb();
+
+	HashWriteLock(htbl, &src->rwlock);
+	src->sig[srcSlot] = CUCKOO_SIG_EMPTY;
+	HashWriteUnlock(htbl, &src->rwlock);
+	HASH_STAT_INC(htbl, collision);
+}
+
+/*
+ * Walk a displacement path starting from bkt until an entry can be pushed into an empty slot
+ * of its alternative bucket, then shift the whole path back by one.
+ *
+ * @return
+ *  the slot freed in bkt, -1 if no path within CUCKOO_MAX_PATH was found
+ */
+static int CuckooMakeSpace(struct hashTable *htbl, unsigned int bkt)
+{
+	unsigned int pathBkt[CUCKOO_MAX_PATH];
+	int pathSlot[CUCKOO_MAX_PATH];
+	unsigned int cur = bkt;
+	unsigned int alt = 0;
+	unsigned int empty = 0;
+	int depth = 0;
+	int slot = 0;
+	int tries = 0;
+	int i = 0;
+
+	for( ; depth < CUCKOO_MAX_PATH; depth++)
+	{
+		/*pick a victim not already on the path*/
+		for( tries = 0; tries < CUCKOO_BUCKET_ENTRIES; tries++)
+		{
+			slot = (htbl->victim++)%CUCKOO_BUCKET_ENTRIES;
+			for( i = 0; i < depth; i++)
+			{
+				if( pathBkt[i] == cur && pathSlot[i] == slot )
+				{
+					break;
+				}
+			}
+			if( i == depth )
+			{
+				break;
+			}
+		}
+		if( tries == CUCKOO_BUCKET_ENTRIES )
+		{
+			return -1;
+		}
+
+		pathBkt[depth] = cur;
+		pathSlot[depth] = slot;
+		alt = CuckooAlt(htbl, cur, htbl->cbucket[cur].sig[slot]);
+		empty = CuckooMatch(&htbl->cbucket[alt], CUCKOO_SIG_EMPTY);
+		if( empty )
+		{
+			unsigned int dstBkt = alt;
+			int dstSlot = __builtin_ctz(empty);
+
+			for( i = depth; i >= 0; i--)
+			{
+				CuckooMove(htbl, pathBkt[i], pathSlot[i], dstBkt, dstSlot);
+				dstBkt = pathBkt[i];
+				dstSlot = pathSlot[i];
+			}
+			return pathSlot[0];
+		}
+		cur = alt;
+	}
+
+	return -1;
+}
+
+static void CuckooFill(struct hashTable *htbl, unsigned int bkt, int slot, uint16_t sig, void *key, void *value, uint64_t timeout)
+{
+	struct CuckooBucket *b = &htbl->cbucket[bkt];
+	struct CuckooEntry *entry = &htbl->centry[bkt*CUCKOO_BUCKET_ENTRIES+slot];
+
+	HashWriteLock(htbl, &b->rwlock);
+	entry->key = key;
+	entry->value = value;
+	entry->timeout = timeout;
+	rte_smp_wmb();
+	b->sig[slot] = sig;
+	HashNoteExpire(htbl->segExpire, bkt*CUCKOO_BUCKET_ENTRIES+slot, timeout);
+	HashWriteUnlock(htbl, &b->rwlock);
+}
+
+/*
+ * Insert or, with a callback, upsert. Writers are serialized, so the key found or not in its two
+ * buckets stays so until the node is written.
+ */
+static int CuckooInsert(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout, struct UpsertCallBack *callback, struct HashNodeCopy *cp)
+{
+	uint16_t sig = 0;
+	unsigned int bkt[2];
+	unsigned int mask[2];
+	unsigned int empty = 0;
+	unsigned int expiredBkt = 0;
+	int expiredSlot = -1;
+	uint64_t currentTime = 0;
+	struct CuckooBucket *b = NULL;
+	struct CuckooEntry *entry = NULL;
+	unsigned int nodeBkt = 0;
+	int nodeSlot = -1;
+	int ret = RET_FAILED;
+	int slot = 0;
+	int i = 0;
+
+	sig = CuckooSig(hash);
+	bkt[0] = hash & htbl->cbucketMask;
+	bkt[1] = CuckooAlt(htbl, bkt[0], sig);
+	currentTime = rte_rdtsc();
+
+	HashSpinLock(htbl, &htbl->writeLock);
+	CuckooMatchPair(&htbl->cbucket[bkt[0]], &htbl->cbucket[bkt[1]], sig, &mask[0], &mask[1]);
+	for( i = 0; i < 2; i++)
+	{
+		b = &htbl->cbucket[bkt[i]];
+		while( mask[i] )
+		{
+			slot = __builtin_ctz(mask[i]);
+			mask[i] &= mask[i]-1;
+			entry = &htbl->centry[bkt[i]*CUCKOO_BUCKET_ENTRIES+slot];
+			if( htbl->ops.cmp(entry->key, key) )
+			{
+				HashWriteLock(htbl, &b->rwlock);
+				if( callback && currentTime < entry->timeout )
+				{
+					if( callback->update )
+					{
+						callback->update(entry->value, callback->userData);
+					}
+					ret = RET_UPDATE;
+				}
+				else
+				{
+					if( callback && callback->init )
+					{
+						callback->init(value, callback->userData);
+					}
+					htbl->ops.assignKey(key, entry->key);
+					htbl->ops.assignValue(value, entry->value);
+					entry->timeout = timeout;
+					HashNoteExpire(htbl->segExpire, bkt[i]*CUCKOO_BUCKET_ENTRIES+slot, timeout);
+					ret = RET_OCCUPY;
+				}
+				HashWriteUnlock(htbl, &b->rwlock);
+				nodeBkt = bkt[i];
+				nodeSlot = slot;
+				goto DONE;
+			}
+			if( expiredSlot < 0 && currentTime >= entry->timeout )
+			{
+				expiredBkt = bkt[i];
+				expiredSlot = slot;
+			}
+		}
+	}
+
+	if( callback && callback->init )
+	{
+		callback->init(value, callback->userData);
+	}
+	for( i = 0; i < 2; i++)
+	{
+		empty = CuckooMatch(&htbl->cbucket[bkt[i]], CUCKOO_SIG_EMPTY);
+		if( empty )
+		{
+			nodeBkt = bkt[i];
+			nodeSlot = __builtin_ctz(empty);
+			CuckooFill(htbl, nodeBkt, nodeSlot, sig, key, value, timeout);
+			ret = RET_NEW;
+			goto DONE;
+		}
+	}
+
+	/*reuse an expired entry of the key's buckets before displacing anyone*/
+	for( i = 0; i < 2 && expiredSlot < 0; i++)
+	{
+		for( slot = 0; slot < CUCKOO_BUCKET_ENTRIES; slot++)
+		{
+			if( currentTime >= htbl->centry[bkt[i]*CUCKOO_BUCKET_ENTRIES+slot].timeout )
+			{
+				expiredBkt = bkt[i];
+				expiredSlot = slot;
+				break;
+			}
+		}
+	}
+	if( expiredSlot >= 0 )
+	{
+		b = &htbl->cbucket[expiredBkt];
+		entry = &htbl->centry[expiredBkt*CUCKOO_BUCKET_ENTRIES+expiredSlot];
+		HashWriteLock(htbl, &b->rwlock);
+		htbl->ops.assignKey(key, entry->key);
+		htbl->ops.assignValue(value, entry->value);
+		entry->timeout = timeout;
+		b->sig[expiredSlot] = sig;
+		HashNoteExpire(htbl->segExpire, expiredBkt*CUCKOO_BUCKET_ENTRIES+expiredSlot, timeout);
+		HashWriteUnlock(htbl, &b->rwlock);
+		HASH_STAT_INC(htbl, expiration);
+		nodeBkt = expiredBkt;
+		nodeSlot = expiredSlot;
+		ret = RET_OCCUPY;
+		goto DONE;
+	}
+
+	for( i = 0; i < 2; i++)
+	{
+		slot = CuckooMakeSpace(htbl, bkt[i]);
+		if( slot >= 0 )
+		{
+			nodeBkt = bkt[i];
+			nodeSlot = slot;
+			CuckooFill(htbl, nodeBkt, nodeSlot, sig, key, value, timeout);
+			ret = RET_NEW;
+			goto DONE;
+		}
+	}
+	HASH_STAT_INC(htbl, failed);
+
+DONE:
+	if( nodeSlot >= 0 && cp && cp->value )
+	{
+		b = &htbl->cbucket[nodeBkt];
+		entry = &htbl->centry[nodeBkt*CUCKOO_BUCKET_ENTRIES+nodeSlot];
+		HashReadLock(htbl, &b->rwlock);
+		htbl->ops.assignValue(entry->value, cp->value);
+		cp->expired = entry->timeout;
+		HashReadUnlock(htbl, &b->rwlock);
+	}
+	HashSpinUnlock(htbl, &htbl->writeLock);
+	return ret;
+}
+
+static int InsertElemCuckoo(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout)
+{
+	return CuckooInsert(htbl, hash, key, value, timeout, NULL, NULL);
+}
+
+static int UpsertCuckoo(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout, struct UpsertCallBack *callback, struct HashNodeCopy *cp)
+{
+	static struct UpsertCallBack none = { NULL, NULL, NULL };
+
+	return CuckooInsert(htbl, hash, key, value, timeout, callback?callback:&none, cp);
+}
+
+/*sweeps hold the writer lock, a displacement must not move a node being reclaimed*/
+static int SweepCuckoo(struct hashTable *htbl, __rte_unused void *ctx, unsigned int start, unsigned int end, uint64_t current, uint64_t *next)
+{
+	struct CuckooBucket *b = NULL;
+	struct CuckooEntry *entry = NULL;
+	unsigned int i = start;
+	int slot = 0;
+	int reclaimed = 0;
+
+	HashSpinLock(htbl, &htbl->writeLock);
+	for( ; i < end; i += CUCKOO_BUCKET_ENTRIES)
+	{
+		b = &htbl->cbucket[i/CUCKOO_BUCKET_ENTRIES];
+		HashWriteLock(htbl, &b->rwlock);
+		for( slot = 0; slot < CUCKOO_BUCKET_ENTRIES; slot++)
+		{
+			if( b->sig[slot] == CUCKOO_SIG_EMPTY )
+			{
+				continue;
+			}
+			entry = &htbl->centry[i+slot];
+			if( current >= entry->timeout )
+			{
+				b->sig[slot] = CUCKOO_SIG_EMPTY;
+				HashExpireNode(htbl, entry->key, entry->value, LCORE_ID_ANY);
+				reclaimed++;
+			}
+			else if( entry->timeout < *next )
+			{
+				*next = entry->timeout;
+			}
+		}
+		HashWriteUnlock(htbl, &b->rwlock);
+	}
+	HashSpinUnlock(htbl, &htbl->writeLock);
+
+	return reclaimed;
+}
+
+static int ExpireCuckoo(struct hashTable *htbl, unsigned int budget)
+{
+	return HashExpireSegments(htbl, htbl->segExpire, htbl->bucketSize, SweepCuckoo, NULL, budget);
+}
+
+/*writers are serialized, so the entries of both buckets are stable while the key is looked for*/
+static int DeleteElemCuckoo(struct hashTable *htbl, unsigned int hash, void *key, void *copy)
+{
+	uint16_t sig = 0;
+	unsigned int bkt[2];
+	unsigned int mask = 0;
+	struct CuckooBucket *b = NULL;
+	struct CuckooEntry *entry = NULL;
+	struct HashNodeCopy *cp = NULL;
+	void *nodeKey = NULL;
+	void *nodeValue = NULL;
+	int slot = 0;
+	int find = 0;
+	int i = 0;
+
+	sig = CuckooSig(hash);
+	bkt[0] = hash & htbl->cbucketMask;
+	bkt[1] = CuckooAlt(htbl, bkt[0], sig);
+	cp = (struct HashNodeCopy*)copy;
+
+	HashSpinLock(htbl, &htbl->writeLock);
+	for( i = 0; i < 2 && !find; i++)
+	{
+		b = &htbl->cbucket[bkt[i]];
+		mask = CuckooMatch(b, sig);
+		while( mask && !find )
+		{
+			slot = __builtin_ctz(mask);
+			mask &= mask-1;
+			entry = &htbl->centry[bkt[i]*CUCKOO_BUCKET_ENTRIES+slot];
+			if( htbl->ops.cmp(entry->key, key) == 1 )
+			{
+				find = 1;
+				HashWriteLock(htbl, &b->rwlock);
+				if( cp && cp->value )
+				{
+					htbl->ops.assignValue(entry->value, cp->value);
+					cp->expired = entry->timeout;
+				}
+				nodeKey = entry->key;
+				nodeValue = entry->value;
+				b->sig[slot] = CUCKOO_SIG_EMPTY;
+				HashWriteUnlock(htbl, &b->rwlock);
+			}
+		}
+	}
+	HashSpinUnlock(htbl, &htbl->writeLock);
+
+	if( !find )
+	{
+		return RET_FAILED;
+	}
+	HashExpireNode(htbl, nodeKey, nodeValue, LCORE_ID_ANY);
+
+	return 0;
+}
+
+static int IterateCuckoo(struct hashTable *htbl, unsigned int start, unsigned int end, fpVisit visit, void *userData, unsigned int *next)
+{
+	struct CuckooBucket *b = NULL;
+	struct CuckooEntry *entry = NULL;
+	uint64_t currentTime = rte_rdtsc();
+	unsigned int i = start;
+	int visited = 0;
+	int stop = 0;
+
+	end = RTE_MIN(end, htbl->bucketSize);
+	for( ; i < end && !stop; i++)
+	{
+		b = &htbl->cbucket[i/CUCKOO_BUCKET_ENTRIES];
+		if( b->sig[i%CUCKOO_BUCKET_ENTRIES] == CUCKOO_SIG_EMPTY )
+		{
+			continue;
+		}
+		entry = &htbl->centry[i];
+		HashReadLock(htbl, &b->rwlock);
+		if( b->sig[i%CUCKOO_BUCKET_ENTRIES] != CUCKOO_SIG_EMPTY && currentTime < entry->timeout )
+		{
+			stop = visit(entry->key, entry->value, entry->timeout, userData);
+			visited++;
+		}
+		HashReadUnlock(htbl, &b->rwlock);
+	}
+	*next = i;
+
+	return visited;
+}
+
+static void PrefetchCuckoo(struct hashTable *htbl, unsigned int hash, int stage)
+{
+	uint16_t sig = CuckooSig(hash);
+	unsigned int prim = hash & htbl->cbucketMask;
+	unsigned int sec = CuckooAlt(htbl, prim, sig);
+	unsigned int primMask = 0;
+	unsigned int secMask = 0;
+
+	if( stage == 0 )
+	{
+		rte_prefetch0(&htbl->cbucket[prim]);
+		rte_prefetch0(&htbl->cbucket[sec]);
+		return;
+	}
+	CuckooMatchPair(&htbl->cbucket[prim], &htbl->cbucket[sec], sig, &primMask, &secMask);
+	if( primMask )
+	{
+		rte_prefetch0(&htbl->centry[prim*CUCKOO_BUCKET_ENTRIES+__builtin_ctz(primMask)]);
+	}
+	else if( secMask )
+	{
+		rte_prefetch0(&htbl->centry[sec*CUCKOO_BUCKET_ENTRIES+__builtin_ctz(secMask)]);
+	}
+}
+
+static void *FindElemCuckoo(struct hashTable *htbl, unsigned int hash, void *key, void *copy, struct UpdateCallBack *callback)
+{
+	uint16_t sig = 0;
+	unsigned int bkt[2];
+	unsigned int mask[2];
+	uint32_t change = 0;
+	uint64_t currentTime = 0;
+	struct CuckooBucket *b = NULL;
+	struct CuckooEntry *entry = NULL;
+	struct HashNodeCopy *cp = NULL;
+	int slot = 0;
+	int find = 0;
+	int i = 0;
+
+	sig = CuckooSig(hash);
+	bkt[0] = hash & htbl->cbucketMask;
+	bkt[1] = CuckooAlt(htbl, bkt[0], sig);
+	currentTime = rte_rdtsc();
+	cp = (struct HashNodeCopy*)copy;
+
+	do
+	{
+		change = htbl->change;
+		rte_smp_rmb();
+		CuckooMatchPair(&htbl->cbucket[bkt[0]], &htbl->cbucket[bkt[1]], sig, &mask[0], &mask[1]);
+		for( i = 0; i < 2 && !find; i++)
+		{
+			b = &htbl->cbucket[bkt[i]];
+			while( mask[i] && !find )
+			{
+				slot = __builtin_ctz(mask[i]);
+				mask[i] &= mask[i]-1;
+				entry = &htbl->centry[bkt[i]*CUCKOO_BUCKET_ENTRIES+slot];
+				HashReadLock(htbl, &b->rwlock);
+				if( (b->sig[slot] == sig) &&
+						(htbl->ops.cmp(entry->key, key) == 1) &&
+						(currentTime < entry->timeout) )
+				{
+					find = 1;
+					if( cp && cp->value )
+					{
+						htbl->ops.assignValue(entry->value, cp->value);
+						cp->expired = entry->timeout;
+					}
+				}
+				HashReadUnlock(htbl, &b->rwlock);
+			}
+		}
+		rte_smp_rmb();
+	} while( !find && change != htbl->change );
+	/*i is the bucket the key was found in plus one*/
+	HashStatLookup(htbl, find, find?i:2);
+
+	if( callback && callback->update && find )
+	{
+		HashWriteLock(htbl, &b->rwlock);
+		/*the bucket was unlocked meanwhile, a delete, sweep or move may have put another key in the slot*/
+		if( b->sig[slot] == sig && htbl->ops.cmp(entry->key, key) == 1 && currentTime < entry->timeout )
+		{
+			callback->update(entry->value, callback->userData);
+		}
+		else
+		{
+			find = 0;
+		}
+		HashWriteUnlock(htbl, &b->rwlock);
+	}
+	return (find?entry->value:NULL);
+}
+
+static inline unsigned char *InlineGroup(struct hashTable *htbl, unsigned int g)
+{
+	return htbl->group + (size_t)(g & htbl->groupMask)*htbl->groupSize;
+}
+
+static inline struct InlineSlot *InlineSlotAt(struct hashTable *htbl, unsigned char *group, int slot)
+{
+	return (struct InlineSlot*)(group + sizeof(struct InlineGroupHeader) + slot*htbl->slotSize);
+}
+
+static inline void *InlineKey(struct InlineSlot *s)
+{
+	return s->data;
+}
+
+static inline void *InlineValue(struct hashTable *htbl, struct InlineSlot *s)
+{
+	return s->data + htbl->ops.keySize;
+}
+
+/*inline keys are plain data compared over keySize, ops.cmp is not used and every field counts*/
+static inline int InlineKeyEqual(struct hashTable *htbl, struct InlineSlot *s, void *key)
+{
+	if( htbl->ops.keySize == sizeof(uint64_t) )
+	{
+		return *(uint64_t*)s->data == *(uint64_t*)key;
+	}
+	return memcmp(s->data, key, htbl->ops.keySize) == 0;
+}
+
+static int InitInline(struct hashTable *htbl, int size)
+{
+	unsigned int count = 0;
+	unsigned int i = 0;
+	unsigned int hdr = sizeof(struct InlineGroupHeader);
+
+	htbl->capacity = size;
+	htbl->slotSize = RTE_ALIGN_CEIL(sizeof(struct InlineSlot) + htbl->ops.keySize + htbl->ops.valueSize, 4);
+	if( htbl->slotSize + hdr <= RTE_CACHE_LINE_SIZE )
+	{
+		htbl->groupSize = RTE_CACHE_LINE_SIZE;
+		htbl->slotsPerGroup = RTE_MIN((RTE_CACHE_LINE_SIZE - hdr)/htbl->slotSize, INLINE_GROUP_SLOTS);
+	}
+	else
+	{
+		htbl->groupSize = RTE_ALIGN_CEIL(htbl->slotSize + hdr, RTE_CACHE_LINE_SIZE);
+		htbl->slotsPerGroup = 1;
+	}
+	htbl->probeGroups = (htbl->probeStep + htbl->slotsPerGroup)/htbl->slotsPerGroup;
+
+	count = ((uint64_t)size*INLINE_LOAD_FACTOR + htbl->slotsPerGroup - 1)/htbl->slotsPerGroup;
+	count = rte_align32pow2(count > 1 ? count : 2);
+	htbl->groupMask = count - 1;
+	htbl->bucketSize = count*htbl->slotsPerGroup;
+
+	/*groups must start on a cache line whatever the allocator returns*/
+	htbl->groupMem = HashMalloc(htbl, (size_t)htbl->groupSize*count + RTE_CACHE_LINE_SIZE);
+	if( !htbl->groupMem )
+	{
+		printf("Malloc inline group failed.\n");
+		return -1;
+	}
+	htbl->group = (unsigned char*)RTE_ALIGN_CEIL((uintptr_t)htbl->groupMem, RTE_CACHE_LINE_SIZE);
+	memset(htbl->group, 0x00, (size_t)htbl->groupSize*count);
+	for( ; i < count; i++)
+	{
+		rte_rwlock_init(&((struct InlineGroupHeader*)InlineGroup(htbl, i))->rwlock);
+	}
+	htbl->st.totalMem = sizeof(*htbl) + htbl->groupSize*count;
+	if( AllocSegments(htbl, htbl->bucketSize) < 0 )
+	{
+		printf("Malloc expiry segments failed.\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static void ReleaseInline(struct hashTable *htbl)
+{
+	if( htbl->groupMem )
+	{
+		htbl->ops.freeFunc(htbl->groupMem, htbl->groupSize*(htbl->groupMask+1) + RTE_CACHE_LINE_SIZE);
+	}
+	FreeSegments(htbl, htbl->bucketSize);
+}
+
+static void TravelInline(struct hashTable *htbl, uint64_t current, int *cnt, int *timeout, int *available)
+{
+	unsigned int g = 0;
+	int i = 0;
+	unsigned char *group = NULL;
+	struct InlineGroupHeader *hdr = NULL;
+	struct InlineSlot *s = NULL;
+
+	for( ; g <= htbl->groupMask; g++)
+	{
+		group = InlineGroup(htbl, g);
+		hdr = (struct InlineGroupHeader*)group;
+		for( i = 0; i < htbl->slotsPerGroup; i++)
+		{
+			if( hdr->status[i] != STATUS_USE )
+			{
+				(*available)++;
+				continue;
+			}
+			s = InlineSlotAt(htbl, group, i);
+			(*cnt)++;
+			if( htbl->ops.assessFunc )
+			{
+				htbl->ops.assessFunc(InlineValue(htbl, s));
+			}
+			if( s->timeout < current )
+			{
+				(*timeout)++;
+			}
+		}
+	}
+}
+
+/*the slot is handed to expireFunc while the group is locked, it is reused as soon as the lock is released*/
+static int SweepInline(struct hashTable *htbl, __rte_unused void *ctx, unsigned int start, unsigned int end, uint64_t current, uint64_t *next)
+{
+	unsigned char *group = NULL;
+	struct InlineGroupHeader *hdr = NULL;
+	struct InlineSlot *s = NULL;
+	unsigned int g = start/htbl->slotsPerGroup;
+	int slot = 0;
+	int reclaimed = 0;
+
+	for( ; g*htbl->slotsPerGroup < end; g++)
+	{
+		group = InlineGroup(htbl, g);
+		hdr = (struct InlineGroupHeader*)group;
+		HashWriteLock(htbl, &hdr->rwlock);
+		for( slot = 0; slot < htbl->slotsPerGroup; slot++)
+		{
+			if( hdr->status[slot] != STATUS_USE )
+			{
+				continue;
+			}
+			s = InlineSlotAt(htbl, group, slot);
+			if( current >= s->timeout )
+			{
+				hdr->status[slot] = STATUS_AVAILABLE;
+				HashExpireNode(htbl, InlineKey(s), InlineValue(htbl, s), LCORE_ID_ANY);
+				reclaimed++;
+			}
+			else if( s->timeout < *next )
+			{
+				*next = s->timeout;
+			}
+		}
+		HashWriteUnlock(htbl, &hdr->rwlock);
+	}
+
+	return reclaimed;
+}
+
+static int ExpireInline(struct hashTable *htbl, unsigned int budget)
+{
+	return HashExpireSegments(htbl, htbl->segExpire, htbl->bucketSize, SweepInline, NULL, budget);
+}
+
+/*key and value point into the slot, they are only valid during the visit*/
+static int IterateInline(struct hashTable *htbl, unsigned int start, unsigned int end, fpVisit visit, void *userData, unsigned int *next)
+{
+	unsigned char *group = NULL;
+	struct InlineGroupHeader *hdr = NULL;
+	struct InlineSlot *s = NULL;
+	uint64_t currentTime = rte_rdtsc();
+	unsigned int i = start;
+	int slot = 0;
+	int visited = 0;
+	int stop = 0;
+
+	end = RTE_MIN(end, htbl->bucketSize);
+	for( ; i < end && !stop; i++)
+	{
+		group = InlineGroup(htbl, i/htbl->slotsPerGroup);
+		hdr = (struct InlineGroupHeader*)group;
+		slot = i%htbl->slotsPerGroup;
+		if( hdr->status[slot] != STATUS_USE )
+		{
+			continue;
+		}
+		s = InlineSlotAt(htbl, group, slot);
+		HashReadLock(htbl, &hdr->rwlock);
+		if( hdr->status[slot] == STATUS_USE && currentTime < s->timeout )
+		{
+			stop = visit(InlineKey(s), InlineValue(htbl, s), s->timeout, userData);
+			visited++;
+		}
+		HashReadUnlock(htbl, &hdr->rwlock);
+	}
+	*next = i;
+
+	return visited;
+}
+
+static void PrefetchInline(struct hashTable *htbl, unsigned int hash, int stage)
+{
+	if( stage == 0 )
+	{
+		rte_prefetch0(InlineGroup(htbl, hash));
+		rte_prefetch0(InlineGroup(htbl, hash+1));
+	}
+}
+
+/*
+ * Every probe group is searched for the key before a slot is taken, so a key never has two slots.
+ * The home group stays write-locked until the node is written, the other groups are locked one at
+ * a time. An insert overwrites the value and the timeout of the node of the key, an upsert only
+ * does when the node expired.
+ */
+static int InlineWrite(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout, struct UpsertCallBack *callback,
+		struct HashNodeCopy *cp, int insert)
+{
+	struct InlineGroupHeader *home = NULL;
+	unsigned char *group = NULL;
+	struct InlineGroupHeader *hdr = NULL;
+	struct InlineSlot *s = NULL;
+	uint64_t currentTime = 0;
+	int count = 0;
+	int slot = 0;
+	int reuseCount = -1;
+	int reuseSlot = -1;
+	int ret = RET_FAILED;
+
+	currentTime = rte_rdtsc();
+	home = (struct InlineGroupHeader*)InlineGroup(htbl, hash);
+
+	HashWriteLock(htbl, &home->rwlock);
+	for( ; count < htbl->probeGroups && ret == RET_FAILED; count++)
+	{
+		group = InlineGroup(htbl, hash+count);
+		hdr = (struct InlineGroupHeader*)group;
+		if( hdr != home )
+		{
+			HashWriteLock(htbl, &hdr->rwlock);
+		}
+		for( slot = 0; slot < htbl->slotsPerGroup; slot++)
+		{
+			s = InlineSlotAt(htbl, group, slot);
+			if( hdr->status[slot] == STATUS_USE && InlineKeyEqual(htbl, s, key) )
+			{
+				if( currentTime < s->timeout && !insert )
+				{
+					if( callback && callback->update )
+					{
+						callback->update(InlineValue(htbl, s), callback->userData);
+					}
+					ret = RET_UPDATE;
+				}
+				else
+				{
+					if( callback && callback->init )
+					{
+						callback->init(value, callback->userData);
+					}
+					if( currentTime >= s->timeout )
+					{
+						HASH_STAT_INC(htbl, expiration);
+					}
+					memcpy(InlineValue(htbl, s), value, htbl->ops.valueSize);
+					s->timeout = timeout;
+					HashNoteExpire(htbl->segExpire, ((hash+count) & htbl->groupMask)*htbl->slotsPerGroup+slot, timeout);
+					ret = RET_OCCUPY;
+				}
+				if( cp && cp->value )
+				{
+					memcpy(cp->value, InlineValue(htbl, s), htbl->ops.valueSize);
+					cp->expired = s->timeout;
+				}
+				break;
+			}
+			if( reuseCount < 0 && (hdr->status[slot] == STATUS_AVAILABLE || currentTime >= s->timeout) )
+			{
+				reuseCount = count;
+				reuseSlot = slot;
+			}
+		}
+		if( hdr != home )
+		{
+			HashWriteUnlock(htbl, &hdr->rwlock);
+		}
+	}
+	if( ret != RET_FAILED || reuseCount < 0 )
+	{
+		goto DONE;
+	}
+	HASH_STAT_ADD(htbl, collision, reuseCount);
+
+	if( callback && callback->init )
+	{
+		callback->init(value, callback->userData);
+	}
+	group = InlineGroup(htbl, hash+reuseCount);
+	hdr = (struct InlineGroupHeader*)group;
+	s = InlineSlotAt(htbl, group, reuseSlot);
+	if( hdr != home )
+	{
+		HashWriteLock(htbl, &hdr->rwlock);
+	}
+	/*checked again, a slot of another group may have been taken meanwhile*/
+	if( hdr->status[reuseSlot] == STATUS_AVAILABLE || currentTime >= s->timeout )
+	{
+		ret = (hdr->status[reuseSlot] == STATUS_AVAILABLE)?RET_NEW:RET_OCCUPY;
+		if( ret == RET_OCCUPY )
+		{
+			HASH_STAT_INC(htbl, expiration);
+		}
+		memcpy(InlineKey(s), key, htbl->ops.keySize);
+		memcpy(InlineValue(htbl, s), value, htbl->ops.valueSize);
+		s->timeout = timeout;
+		hdr->status[reuseSlot] = STATUS_USE;
+		HashNoteExpire(htbl->segExpire, ((hash+reuseCount) & htbl->groupMask)*htbl->slotsPerGroup+reuseSlot, timeout);
+		if( cp && cp->value )
+		{
+			memcpy(cp->value, InlineValue(htbl, s), htbl->ops.valueSize);
+			cp->expired = s->timeout;
+		}
+	}
+	if( hdr != home )
+	{
+		HashWriteUnlock(htbl, &hdr->rwlock);
+	}
+
+DONE:
+	HashWriteUnlock(htbl, &home->rwlock);
+	if( ret == RET_FAILED )
+	{
+		HASH_STAT_INC(htbl, failed);
+	}
+	return ret;
+}
+
+static int InsertElemInline(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout)
+{
+	return InlineWrite(htbl, hash, key, value, timeout, NULL, NULL, 1);
+}
+
+static int UpsertInline(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout, struct UpsertCallBack *callback, struct HashNodeCopy *cp)
+{
+	return InlineWrite(htbl, hash, key, value, timeout, callback, cp, 0);
+}
+
+/*the lookup of the inline layout scans every probe group, so a slot is simply freed*/
+static int DeleteElemInline(struct hashTable *htbl, unsigned int hash, void *key, void *copy)
+{
+	unsigned char *group = NULL;
+	struct InlineGroupHeader *hdr = NULL;
+	struct InlineSlot *s = NULL;
+	struct HashNodeCopy *cp = NULL;
+	int count = 0;
+	int slot = 0;
+
+	cp = (struct HashNodeCopy*)copy;
+
+	for( ; count < htbl->probeGroups; count++)
+	{
+		group = InlineGroup(htbl, hash+count);
+		hdr = (struct InlineGroupHeader*)group;
+		HashWriteLock(htbl, &hdr->rwlock);
+		for( slot = 0; slot < htbl->slotsPerGroup; slot++)
+		{
+			s = InlineSlotAt(htbl, group, slot);
+			if( hdr->status[slot] == STATUS_USE && InlineKeyEqual(htbl, s, key) )
+			{
+				if( cp && cp->value )
+				{
+					memcpy(cp->value, InlineValue(htbl, s), htbl->ops.valueSize);
+					cp->expired = s->timeout;
+				}
+				hdr->status[slot] = STATUS_AVAILABLE;
+				HashExpireNode(htbl, InlineKey(s), InlineValue(htbl, s), LCORE_ID_ANY);
+				HashWriteUnlock(htbl, &hdr->rwlock);
+				return 0;
+			}
+		}
+		HashWriteUnlock(htbl, &hdr->rwlock);
+	}
+
+	return RET_FAILED;
+}
+
+static void *FindElemInline(struct hashTable *htbl, unsigned int hash, void *key, void *copy, struct UpdateCallBack *callback)
+{
+	unsigned char *group = NULL;
+	struct InlineGroupHeader *hdr = NULL;
+	struct InlineSlot *s = NULL;
+	uint64_t currentTime = 0;
+	struct HashNodeCopy *cp = NULL;
+	int count = 0;
+	int slot = 0;
+	int find = 0;
+
+	currentTime = rte_rdtsc();
+	cp = (struct HashNodeCopy*)copy;
+
+	for( ; count < htbl->probeGroups && !find; count++)
+	{
+		group = InlineGroup(htbl, hash+count);
+		hdr = (struct InlineGroupHeader*)group;
+		HashReadLock(htbl, &hdr->rwlock);
+		for( slot = 0; slot < htbl->slotsPerGroup; slot++)
+		{
+			s = InlineSlotAt(htbl, group, slot);
+			if( (hdr->status[slot] == STATUS_USE) &&
+					InlineKeyEqual(htbl, s, key) &&
+					(currentTime < s->timeout) )
+			{
+				find = 1;
+				if( cp && cp->value )
+				{
+					memcpy(cp->value, InlineValue(htbl, s), htbl->ops.valueSize);
+					cp->expired = s->timeout;
+				}
+				break;
+			}
+		}
+		HashReadUnlock(htbl, &hdr->rwlock);
+	}
+
+	HashStatLookup(htbl, find, count);
+
+	if( callback && callback->update && find )
+	{
+		HashWriteLock(htbl, &hdr->rwlock);
+		/*the group was unlocked meanwhile, its slot may have been freed or given to another key*/
+		if( hdr->status[slot] == STATUS_USE && InlineKeyEqual(htbl, s, key) && currentTime < s->timeout )
+		{
+			callback->update(InlineValue(htbl, s), callback->userData);
+		}
+		else
+		{
+			find = 0;
+		}
+		HashWriteUnlock(htbl, &hdr->rwlock);
+	}
+	return (find?InlineValue(htbl, s):NULL);
+}
+
+static inline unsigned int RobinNext(struct hashTable *htbl, unsigned int idx)
+{
+	return (idx+1 == htbl->bucketSize) ? 0 : idx+1;
+}
+
+/*change is odd while slots are rewritten, readers retry a lookup which overlapped it*/
+static inline void RobinWriteBegin(struct hashTable *htbl)
+{
+	htbl->change++;
+	rte_smp_wmb();
+}
+
+static inline void RobinWriteEnd(struct hashTable *htbl)
+{
+	rte_smp_wmb();
+	htbl->change++;
+}
+
+/*the node is written before the status, a reader never sees a used slot without its key*/
+static inline void RobinStore(struct hashTable *htbl, unsigned int idx, struct RobinSlot *node)
+{
+	struct RobinSlot *s = &htbl->rslot[idx];
+
+	HashFilterMove(htbl, node->hash);
+	s->key = node->key;
+	s->value = node->value;
+	s->timeout = node->timeout;
+	s->hash = node->hash;
+	s->dist = node->dist;
+	rte_smp_wmb();
+	s->status = STATUS_USE;
+	HashNoteExpire(htbl->segExpire, idx, node->timeout);
+	if( node->dist > htbl->longest )
+	{
+		htbl->longest = node->dist;
+	}
+}
+
+static int InitRobin(struct hashTable *htbl, int size)
+{
+	htbl->capacity = size;
+	htbl->bucketSize = RTE_MAX((uint64_t)size*100/ROBIN_LOAD_PERCENT, 2);
+	htbl->maxDisplacement = RTE_MIN(ROBIN_MAX_DISPLACEMENT, htbl->bucketSize - 1);
+	htbl->rslot = HashMalloc(htbl, sizeof(struct RobinSlot)*htbl->bucketSize);
+	if( !htbl->rslot )
+	{
+		printf("Malloc robin hood slots failed.\n");
+		return -1;
+	}
+	memset(htbl->rslot, 0x00, sizeof(struct RobinSlot)*htbl->bucketSize);
+	rte_spinlock_init(&htbl->writeLock);
+	htbl->change = 0;
+	htbl->st.totalMem = sizeof(*htbl) + sizeof(struct RobinSlot)*htbl->bucketSize;
+	if( AllocSegments(htbl, htbl->bucketSize) < 0 )
+	{
+		printf("Malloc expiry segments failed.\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static void ReleaseRobin(struct hashTable *htbl)
+{
+	if( htbl->rslot )
+	{
+		htbl->ops.freeFunc(htbl->rslot, sizeof(struct RobinSlot)*htbl->bucketSize);
+	}
+	FreeSegments(htbl, htbl->bucketSize);
+}
+
+static void TravelRobin(struct hashTable *htbl, uint64_t current, int *cnt, int *timeout, int *available)
+{
+	struct RobinSlot *s = NULL;
+	unsigned int i = 0;
+
+	for( ; i < htbl->bucketSize; i++)
+	{
+		s = &htbl->rslot[i];
+		if( s->status != STATUS_USE )
+		{
+			(*available)++;
+			continue;
+		}
+		(*cnt)++;
+		if( htbl->ops.assessFunc )
+		{
+			htbl->ops.assessFunc(s->value);
+		}
+		if( s->timeout < current )
+		{
+			(*timeout)++;
+		}
+	}
+}
+
+/*
+ * Look for the key along its chain, which ends at a free slot or at a node closer to its own home
+ * slot than the key would be. The writer lock must be held.
+ *
+ * @return
+ *  the slot index of the key, -1 if not found. expired is set to the first expired node the key
+ *  can take the place of without breaking the order of the chain, -1 if none.
+ */
+static int RobinLocate(struct hashTable *htbl, unsigned int hash, void *key, uint64_t currentTime, int *expired)
+{
+	struct RobinSlot *s = NULL;
+	unsigned int idx = hash%htbl->bucketSize;
+	unsigned int dist = 0;
+
+	*expired = -1;
+	for( ; dist <= htbl->longest; dist++, idx = RobinNext(htbl, idx))
+	{
+		s = &htbl->rslot[idx];
+		if( s->status != STATUS_USE || s->dist < dist )
+		{
+			break;
+		}
+		if( s->hash == hash && htbl->ops.cmp(s->key, key) )
+		{
+			return idx;
+		}
+		if( *expired < 0 && s->dist == dist && currentTime >= s->timeout )
+		{
+			*expired = idx;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Walk from the home slot to the first free slot, swapping the node carried with any node closer
+ * to its home slot. The walk is checked first so that nothing is moved when a node would end up
+ * farther than maxDisplacement.
+ */
+static int RobinPlace(struct hashTable *htbl, struct RobinSlot *node)
+{
+	struct RobinSlot tmp;
+	struct RobinSlot *s = NULL;
+	unsigned int home = node->hash%htbl->bucketSize;
+	unsigned int idx = home;
+	unsigned int carried = 0;
+	unsigned int count = 0;
+
+	for( ; htbl->rslot[idx].status == STATUS_USE; idx = RobinNext(htbl, idx))
+	{
+		if( htbl->rslot[idx].dist < carried )
+		{
+			carried = htbl->rslot[idx].dist;
+		}
+		if( ++carried > htbl->maxDisplacement || ++count == htbl->bucketSize )
+		{
+			return -1;
+		}
+	}
+
+	RobinWriteBegin(htbl);
+	for( idx = home, node->dist = 0; ; idx = RobinNext(htbl, idx), node->dist++)
+	{
+		s = &htbl->rslot[idx];
+		if( s->status != STATUS_USE )
+		{
+			RobinStore(htbl, idx, node);
+			break;
+		}
+		if( s->dist < node->dist )
+		{
+			tmp = *s;
+			RobinStore(htbl, idx, node);
+			*node = tmp;
+		}
+		HASH_STAT_INC(htbl, collision);
+	}
+	RobinWriteEnd(htbl);
+
+	return 0;
+}
+
+/*shift the nodes behind a removed one back by one slot, as far as they are not in their home slot*/
+static void RobinRemove(struct hashTable *htbl, unsigned int idx)
+{
+	struct RobinSlot *s = NULL;
+	unsigned int next = RobinNext(htbl, idx);
+	unsigned int count = 0;
+
+	RobinWriteBegin(htbl);
+	for( ; count < htbl->bucketSize; count++, idx = next, next = RobinNext(htbl, next))
+	{
+		s = &htbl->rslot[next];
+		if( s->status != STATUS_USE || s->dist == 0 )
+		{
+			break;
+		}
+		s->dist--;
+		RobinStore(htbl, idx, s);
+	}
+	htbl->rslot[idx].status = STATUS_AVAILABLE;
+	RobinWriteEnd(htbl);
+}
+
+/*
+ * Insert or, with a callback, upsert. An expired node is reused in place when the key may take
+ * its slot, otherwise it is left to the sweep.
+ */
+static int RobinInsert(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout, struct UpsertCallBack *callback, struct HashNodeCopy *cp)
+{
+	struct RobinSlot node;
+	struct RobinSlot *s = NULL;
+	uint64_t currentTime = 0;
+	int expired = -1;
+	int idx = 0;
+	int ret = RET_FAILED;
+
+	currentTime = rte_rdtsc();
+
+	HashSpinLock(htbl, &htbl->writeLock);
+	idx = RobinLocate(htbl, hash, key, currentTime, &expired);
+	if( idx >= 0 && callback && currentTime < htbl->rslot[idx].timeout )
+	{
+		s = &htbl->rslot[idx];
+		RobinWriteBegin(htbl);
+		if( callback->update )
+		{
+			callback->update(s->value, callback->userData);
+		}
+		RobinWriteEnd(htbl);
+		ret = RET_UPDATE;
+		goto DONE;
+	}
+	if( callback && callback->init )
+	{
+		callback->init(value, callback->userData);
+	}
+	if( idx < 0 && expired >= 0 )
+	{
+		idx = expired;
+		HASH_STAT_INC(htbl, expiration);
+	}
+	if( idx >= 0 )
+	{
+		s = &htbl->rslot[idx];
+		RobinWriteBegin(htbl);
+		htbl->ops.assignKey(key, s->key);
+		htbl->ops.assignValue(value, s->value);
+		/*an expired node of another key may be taken, its distance is the same*/
+		s->hash = hash;
+		s->timeout = timeout;
+		HashNoteExpire(htbl->segExpire, idx, timeout);
+		RobinWriteEnd(htbl);
+		ret = RET_OCCUPY;
+		goto DONE;
+	}
+
+	node.key = key;
+	node.value = value;
+	node.timeout = timeout;
+	node.hash = hash;
+	if( RobinPlace(htbl, &node) == 0 )
+	{
+		ret = RET_NEW;
+	}
+	else
+	{
+		HASH_STAT_INC(htbl, failed);
+	}
+
+DONE:
+	/*writers are serialized, the node can not change before the lock is released*/
+	if( ret == RET_NEW && cp && cp->value )
+	{
+		htbl->ops.assignValue(value, cp->value);
+		cp->expired = timeout;
+	}
+	else if( ret != RET_FAILED && cp && cp->value )
+	{
+		htbl->ops.assignValue(s->value, cp->value);
+		cp->expired = s->timeout;
+	}
+	HashSpinUnlock(htbl, &htbl->writeLock);
+	return ret;
+}
+
+static int InsertElemRobin(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout)
+{
+	return RobinInsert(htbl, hash, key, value, timeout, NULL, NULL);
+}
+
+static int UpsertRobin(struct hashTable *htbl, unsigned int hash, void *key, void *value, uint64_t timeout, struct UpsertCallBack *callback, struct HashNodeCopy *cp)
+{
+	static struct UpsertCallBack none = { NULL, NULL, NULL };
+
+	return RobinInsert(htbl, hash, key, value, timeout, callback?callback:&none, cp);
+}
+
+static void *FindElemRobin(struct hashTable *htbl, unsigned int hash, void *key, void *copy, struct UpdateCallBack *callback)
+{
+	struct RobinSlot *s = NULL;
+	struct HashNodeCopy *cp = NULL;
+	uint64_t currentTime = 0;
+	uint32_t change = 0;
+	unsigned int idx = 0;
+	unsigned int dist = 0;
+	void *value = NULL;
+	int expired = -1;
+	int found = 0;
+
+	currentTime = rte_rdtsc();
+	cp = (struct HashNodeCopy*)copy;
+
+	for( ; ; )
+	{
+		change = htbl->change;
+		if( change & 1 )
+		{
+			rte_pause();
+			continue;
+		}
+		rte_smp_rmb();
+		value = NULL;
+		idx = hash%htbl->bucketSize;
+		for( dist = 0; dist <= htbl->longest; dist++, idx = RobinNext(htbl, idx))
+		{
+			s = &htbl->rslot[idx];
+			if( s->status != STATUS_USE || s->dist < dist )
+			{
+				break;
+			}
+			rte_smp_rmb();
+			if( s->hash == hash && htbl->ops.cmp(s->key, key) == 1 )
+			{
+				if( currentTime < s->timeout )
+				{
+					value = s->value;
+					if( cp && cp->value )
+					{
+						htbl->ops.assignValue(value, cp->value);
+						cp->expired = s->timeout;
+					}
+				}
+				break;
+			}
+		}
+		rte_smp_rmb();
+		if( change == htbl->change )
+		{
+			break;
+		}
+	}
+	HashStatLookup(htbl, value != NULL, dist+1);
+
+	if( callback && callback->update && value )
+	{
+		HashSpinLock(htbl, &htbl->writeLock);
+		/*value was read without the lock, a delete or sweep may have given it back since*/
+		found = RobinLocate(htbl, hash, key, 0, &expired);
+		if( found >= 0 && htbl->rslot[found].value == value && currentTime < htbl->rslot[found].timeout )
+		{
+			RobinWriteBegin(htbl);
+			callback->update(value, callback->userData);
+			RobinWriteEnd(htbl);
+		}
+		else
+		{
+			value = NULL;
+		}
+		HashSpinUnlock(htbl, &htbl->writeLock);
+	}
+	return value;
+}
+
+static int DeleteElemRobin(struct hashTable *htbl, unsigned int hash, void *key, void *copy)
+{
+	struct RobinSlot *s = NULL;
+	struct HashNodeCopy *cp = NULL;
+	void *nodeKey = NULL;
+	void *nodeValue = NULL;
+	int expired = -1;
+	int idx = 0;
+
+	cp = (struct HashNodeCopy*)copy;
+
+	HashSpinLock(htbl, &htbl->writeLock);
+	idx = RobinLocate(htbl, hash, key, 0, &expired);
+	if( idx < 0 )
+	{
+		HashSpinUnlock(htbl, &htbl->writeLock);
+		return RET_FAILED;
+	}
+	s = &htbl->rslot[idx];
+	if( cp && cp->value )
+	{
+		htbl->ops.assignValue(s->value, cp->value);
+		cp->expired = s->timeout;
+	}
+	nodeKey = s->key;
+	nodeValue = s->value;
+	RobinRemove(htbl, idx);
+	HashSpinUnlock(htbl, &htbl->writeLock);
+	HashExpireNode(htbl, nodeKey, nodeValue, LCORE_ID_ANY);
+
+	return 0;
+}
+
+/*a removal shifts the following nodes back, so the slot is examined again*/
+static int SweepRobin(struct hashTable *htbl, __rte_unused void *ctx, unsigned int start, unsigned int end, uint64_t current, uint64_t *next)
+{
+	struct RobinSlot *s = NULL;
+	void *nodeKey = NULL;
+	void *nodeValue = NULL;
+	unsigned int i = start;
+	int reclaimed = 0;
+
+	HashSpinLock(htbl, &htbl->writeLock);
+	while( i < end )
+	{
+		s = &htbl->rslot[i];
+		if( s->status == STATUS_USE && current >= s->timeout )
+		{
+			nodeKey = s->key;
+			nodeValue = s->value;
+			RobinRemove(htbl, i);
+			HashExpireNode(htbl, nodeKey, nodeValue, LCORE_ID_ANY);
+			reclaimed++;
+			continue;
+		}
+		if( s->status == STATUS_USE && s->timeout < *next )
+		{
+			*next = s->timeout;
+		}
+		i++;
+	}
+	HashSpinUnlock(htbl, &htbl->writeLock);
+
+	return reclaimed;
+}
+
+static int ExpireRobin(struct hashTable *htbl, unsigned int budget)
+{
+	return HashExpireSegments(htbl, htbl->segExpire, htbl->bucketSize, SweepRobin, NULL, budget);
+}
+
+/*nodes are moved by inserts and removals, one moved between two calls may be visited twice or missed*/
+static int IterateRobin(struct hashTable *htbl, unsigned int start, unsigned int end, fpVisit visit, void *userData, unsigned int *next)
+{
+	struct RobinSlot *s = NULL;
+	uint64_t currentTime = rte_rdtsc();
+	unsigned int i = start;
+	int visited = 0;
+	int stop = 0;
+
+	end = RTE_MIN(end, htbl->bucketSize);
+	HashSpinLock(htbl, &htbl->writeLock);
+	for( ; i < end && !stop; i++)
+	{
+		s = &htbl->rslot[i];
+		if( s->status == STATUS_USE && currentTime < s->timeout )
+		{
+			stop = visit(s->key, s->value, s->timeout, userData);
+			visited++;
+		}
+	}
+	HashSpinUnlock(htbl, &htbl->writeLock);
+	*next = i;
+
+	return visited;
+}
+
+static void PrefetchRobin(struct hashTable *htbl, unsigned int hash, int stage)
+{
+	struct RobinSlot *s = &htbl->rslot[hash%htbl->bucketSize];
+
+	if( stage == 0 )
+	{
+		rte_prefetch0(s);
+		rte_prefetch0(s + 2);
+	}
+	else if( s->status == STATUS_USE )
+	{
+		rte_prefetch0(s->key);
+	}
+}
+
+struct HashInterface gHashInf[HASH_STRATEGY_MAX] =
+{
+	[HASH_STRATEGY_SELF_EXPIRED] = 
+	{
+		.insert = ListInsert,
+		.search = ListFind,
+		.init = InitList,
+		.release = ReleaseList,
+		.travel = TravelList,
+		.resize = ResizeList,
+		.maintain = MaintainList,
+		.prefetch = PrefetchList,
+		.expire = ExpireList,
+		.remove = ListDelete,
+		.iterate = IterateList,
+		.upsert = ListUpsert,
+		.reclaim = ReclaimList,
+		.invalidate = InvalidateList
+	},
+
+	[HASH_STRATEGY_LRU] = 
+	{
+		.insert = ListInsert,
+		.search = ListFind,
+		.init = InitList,
+		.release = ReleaseList,
+		.travel = TravelList,
+		.resize = ResizeList,
+		.maintain = MaintainList,
+		.prefetch = PrefetchList,
+		.expire = ExpireList,
+		.remove = ListDelete,
+		.iterate = IterateList,
+		.upsert = ListUpsert,
+		.reclaim = ReclaimList,
+		.invalidate = InvalidateList
+	},
+
+	[HASH_STRATEGY_CLOCK] = 
+	{
+		.insert = ListInsert,
+		.search = ListFind,
+		.init = InitList,
+		.release = ReleaseList,
+		.travel = TravelList,
+		.resize = ResizeList,
+		.maintain = MaintainList,
+		.prefetch = PrefetchList,
+		.expire = ExpireList,
+		.remove = ListDelete,
+		.iterate = IterateList,
+		.upsert = ListUpsert,
+		.reclaim = ReclaimList,
+		.invalidate = InvalidateList
+	},
+
+	[HASH_STRATEGY_CUCKOO] = 
+	{
+		.insert = InsertElemCuckoo,
+		.search = FindElemCuckoo,
+		.init = InitCuckoo,
+		.release = ReleaseCuckoo,
+		.travel = TravelCuckoo,
+		.prefetch = PrefetchCuckoo,
+		.expire = ExpireCuckoo,
+		.remove = DeleteElemCuckoo,
+		.iterate = IterateCuckoo,
+		.upsert = UpsertCuckoo
+	},
+
+	[HASH_STRATEGY_INLINE] = 
+	{
+		.insert = InsertElemInline,
+		.search = FindElemInline,
+		.init = InitInline,
+		.release = ReleaseInline,
+		.travel = TravelInline,
+		.prefetch = PrefetchInline,
+		.expire = ExpireInline,
+		.remove = DeleteElemInline,
+		.iterate = IterateInline,
+		.upsert = UpsertInline
+	},
+
+	[HASH_STRATEGY_ROBINHOOD] = 
+	{
+		.insert = InsertElemRobin,
+		.search = FindElemRobin,
+		.init = InitRobin,
+		.release = ReleaseRobin,
+		.travel = TravelRobin,
+		.prefetch = PrefetchRobin,
+		.expire = ExpireRobin,
+		.remove = DeleteElemRobin,
+		.iterate = IterateRobin,
+		.upsert = UpsertRobin
+	}
+};
+
+static inline void HashStatInsert(struct hashTable *htbl, int ret)
+{
+	if( ret == RET_NEW )
+	{
+		HASH_STAT_INC(htbl, insert);
+	}
+	else if( ret == RET_OCCUPY )
+	{
+		HASH_STAT_INC(htbl, occupy);
+	}
+	else if( ret == RET_UPDATE )
+	{
+		HASH_STAT_INC(htbl, hit);
+	}
+}
+
+static int InitStage(struct hashTable *htbl)
+{
+	unsigned int unit = 0;
+	unsigned int i = 0;
+	unsigned int j = 0;
+
+	/*each stage is written by its lcore only, it must not share a cache line whatever the allocator returns*/
+	htbl->stageMem = HashMalloc(htbl, sizeof(struct HashStage)*RTE_MAX_LCORE + RTE_CACHE_LINE_SIZE);
+	if( !htbl->stageMem )
+	{
+		return -1;
+	}
+	htbl->stage = (struct HashStage*)RTE_ALIGN_CEIL((uintptr_t)htbl->stageMem, RTE_CACHE_LINE_SIZE);
+	memset(htbl->stage, 0x00, sizeof(struct HashStage)*RTE_MAX_LCORE);
+	htbl->st.totalMem += sizeof(struct HashStage)*RTE_MAX_LCORE + RTE_CACHE_LINE_SIZE;
+	if( htbl->mode != HASH_STRATEGY_INLINE )
+	{
+		return 0;
+	}
+
+	unit = htbl->ops.keySize + htbl->ops.valueSize;
+	htbl->stageData = HashMalloc(htbl, (size_t)unit*HASH_STAGE_SIZE*RTE_MAX_LCORE);
+	if( !htbl->stageData )
+	{
+		return -1;
+	}
+	htbl->st.totalMem += unit*HASH_STAGE_SIZE*RTE_MAX_LCORE;
+	for( i = 0; i < RTE_MAX_LCORE; i++)
+	{
+		htbl->stage[i].data = htbl->stageData + (size_t)unit*HASH_STAGE_SIZE*i;
+		for( j = 0; j < HASH_STAGE_SIZE; j++)
+		{
+			htbl->stage[i].entry[j].key = htbl->stage[i].data + unit*j;
+			htbl->stage[i].entry[j].value = htbl->stage[i].data + unit*j + htbl->ops.keySize;
+		}
+	}
+
+	return 0;
+}
+
+static void ReleaseStage(struct hashTable *htbl)
+{
+	if( htbl->stageData )
+	{
+		htbl->ops.freeFunc(htbl->stageData, (htbl->ops.keySize + htbl->ops.valueSize)*HASH_STAGE_SIZE*RTE_MAX_LCORE);
+	}
+	if( htbl->stageMem )
+	{
+		htbl->ops.freeFunc(htbl->stageMem, sizeof(struct HashStage)*RTE_MAX_LCORE + RTE_CACHE_LINE_SIZE);
+	}
+}
+
+/*the stage of the calling lcore, NULL without HASH_TABLE_F_WRITE_COMBINE or outside of an lcore*/
+static inline struct HashStage *HashStageOf(struct hashTable *htbl)
+{
+	unsigned int lcore = 0;
+
+	if( !htbl->stage )
+	{
+		return NULL;
+	}
+	lcore = rte_lcore_id();
+	return lcore < RTE_MAX_LCORE ? &htbl->stage[lcore] : NULL;
+}
+
+/*index of the live staged node of key, -1 if none*/
+static int StageSearch(struct hashTable *htbl, struct HashStage *stage, unsigned int hash, void *key)
+{
+	unsigned int i = 0;
+
+	for( ; i < stage->count; i++)
+	{
+		if( stage->hash[i] == hash && htbl->ops.cmp(stage->entry[i].key, key) == 1 )
+		{
+			if( htbl->mode != HASH_STRATEGY_LRU && rte_rdtsc() >= stage->entry[i].timeout )
+			{
+				return -1;
+			}
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*the slot the node is first probed in, the flush inserts in this order*/
+static inline unsigned int HashHome(struct hashTable *htbl, unsigned int hash)
+{
+	switch( htbl->mode )
+	{
+		case HASH_STRATEGY_CUCKOO:
+			return hash & htbl->cbucketMask;
+		case HASH_STRATEGY_INLINE:
+			return hash & htbl->groupMask;
+		case HASH_STRATEGY_ROBINHOOD:
+			return hash%htbl->bucketSize;
+		default:
+			return hash%htbl->list->size;
+	}
+}
+
+/*
+ * Insert the staged nodes sorted by their home slot, so the table is walked in address order
+ * and the buckets of the next nodes are prefetched while one is inserted. The cuckoo and Robin
+ * Hood writers take writeLock once for the whole batch instead of once per node.
+ */
+static void HashStageFlush(struct hashTable *htbl, struct HashStage *stage)
+{
+	unsigned int home[HASH_STAGE_SIZE];
+	unsigned char order[HASH_STAGE_SIZE];
+	int ret[HASH_STAGE_SIZE];
+	struct HashStageEntry *e = NULL;
+	unsigned int count = stage->count;
+	unsigned int i = 0;
+	unsigned int j = 0;
+	unsigned char idx = 0;
+	int batched = (htbl->mode == HASH_STRATEGY_CUCKOO || htbl->mode == HASH_STRATEGY_ROBINHOOD);
+
+	if( !count )
+	{
+		return;
+	}
+
+	for( i = 0; i < count; i++)
+	{
+		home[i] = HashHome(htbl, stage->hash[i]);
+		for( j = i; j > 0 && home[order[j-1]] > home[i]; j--)
+		{
+			order[j] = order[j-1];
+		}
+		order[j] = i;
+	}
+	for( i = 0; i < count && i < HASH_STAGE_PREFETCH; i++)
+	{
+		htbl->inf->prefetch(htbl, stage->hash[order[i]], 0);
+	}
+
+	if( batched )
+	{
+		HashSpinLock(htbl, &htbl->writeLock);
+		tHashFlushing = htbl;
+	}
+	for( i = 0; i < count; i++)
+	{
+		if( i + HASH_STAGE_PREFETCH < count )
+		{
+			htbl->inf->prefetch(htbl, stage->hash[order[i+HASH_STAGE_PREFETCH]], 0);
+		}
+		idx = order[i];
+		e = &stage->entry[idx];
+		HashFilterAdd(htbl, stage->hash[idx]);
+		if( e->upsert )
+		{
+			ret[idx] = htbl->inf->upsert(htbl, stage->hash[idx], e->key, e->value, e->timeout, NULL, NULL);
+		}
+		else
+		{
+			ret[idx] = htbl->inf->insert(htbl, stage->hash[idx], e->key, e->value, e->timeout);
+		}
+		HashStatInsert(htbl, ret[idx]);
+	}
+	if( batched )
+	{
+		tHashFlushing = NULL;
+		HashSpinUnlock(htbl, &htbl->writeLock);
+	}
+
+	/*the table keeps the objects of a new node only, the others go back to the caller*/
+	stage->count = 0;
+	if( htbl->mode != HASH_STRATEGY_INLINE )
+	{
+		for( i = 0; i < count; i++)
+		{
+			if( ret[i] != RET_NEW )
+			{
+				HashExpireNode(htbl, stage->entry[i].key, stage->entry[i].value, HashOwner());
+			}
+		}
+	}
+}
+
+/*
+ * The node replaces a staged node of the same key, as an insert overwrites the node of its key.
+ * upsert is set for a new key of an upsert.
+ */
+static int StageInsert(struct hashTable *htbl, struct HashStage *stage, unsigned int hash, void *key, void *value, uint64_t timeout, int upsert)
+{
+	struct HashStageEntry *e = NULL;
+	int i = StageSearch(htbl, stage, hash, key);
+
+	if( i >= 0 )
+	{
+		e = &stage->entry[i];
+		htbl->ops.assignValue(value, e->value);
+		e->timeout = timeout;
+		e->upsert = upsert;
+		HASH_STAT_INC(htbl, occupy);
+		return RET_OCCUPY;
+	}
+
+	if( !stage->count )
+	{
+		stage->since = rte_rdtsc();
+	}
+	i = stage->count++;
+	e = &stage->entry[i];
+	stage->hash[i] = hash;
+	e->timeout = timeout;
+	e->upsert = upsert;
+	if( htbl->mode == HASH_STRATEGY_INLINE )
+	{
+		memcpy(e->key, key, htbl->ops.keySize);
+		memcpy(e->value, value, htbl->ops.valueSize);
+	}
+	else
+	{
+		e->key = key;
+		e->value = value;
+	}
+	HASH_STAT_INC(htbl, staged);
+
+	if( stage->count == HASH_STAGE_SIZE )
+	{
+		HashStageFlush(htbl, stage);
+	}
+	return RET_NEW;
+}
+
+static void *StageFind(struct hashTable *htbl, struct HashStage *stage, unsigned int hash, void *key, void *copy, struct UpdateCallBack *callback)
+{
+	struct HashNodeCopy *cp = (struct HashNodeCopy*)copy;
+	struct HashStageEntry *e = NULL;
+	int i = StageSearch(htbl, stage, hash, key);
+
+	if( i < 0 )
+	{
+		return NULL;
+	}
+
+	e = &stage->entry[i];
+	if( cp && cp->value )
+	{
+		htbl->ops.assignValue(e->value, cp->value);
+		cp->expired = e->timeout;
+	}
+	if( callback && callback->update )
+	{
+		callback->update(e->value, callback->userData);
+	}
+	HASH_STAT_INC(htbl, hit);
+
+	return e->value;
+}
+
+struct StageUpsertCopy
+{
+	struct hashTable *htbl;
+	struct UpsertCallBack *callback;
+	struct HashNodeCopy *copy;
+};
+
+/*the copy of a lookup is taken before its update, an upsert copies the updated value*/
+static void StageUpdateCopy(void *value, void *userData)
+{
+	struct StageUpsertCopy *uc = (struct StageUpsertCopy*)userData;
+
+	if( uc->callback && uc->callback->update )
+	{
+		uc->callback->update(value, uc->callback->userData);
+	}
+	if( uc->copy && uc->copy->value )
+	{
+		uc->htbl->ops.assignValue(value, uc->copy->value);
+	}
+}
+
+/*
+ * An upsert of a key in the table updates it in place. A new key is initialized and staged
+ * without probing the table for a free slot, so two lcores upserting the same new key at once
+ * both return RET_NEW. The flush of the later one finds the key and leaves its node alone, see
+ * HASH_TABLE_F_WRITE_COMBINE.
+ */
+static int StageUpsert(struct hashTable *htbl, struct HashStage *stage, unsigned int hash, void *key, void *value, uint64_t timeout,
+		struct UpsertCallBack *callback, struct HashNodeCopy *copy)
+{
+	struct StageUpsertCopy uc = { htbl, callback, copy };
+	struct UpdateCallBack update = { StageUpdateCopy, &uc };
+	struct HashStageEntry *e = NULL;
+	int i = StageSearch(htbl, stage, hash, key);
+
+	if( i >= 0 )
+	{
+		e = &stage->entry[i];
+		if( callback && callback->update )
+		{
+			callback->update(e->value, callback->userData);
+		}
+		if( copy && copy->value )
+		{
+			htbl->ops.assignValue(e->value, copy->value);
+			copy->expired = e->timeout;
+		}
+		HASH_STAT_INC(htbl, hit);
+		return RET_UPDATE;
+	}
+	if( !HashFilterMiss(htbl, hash) && htbl->inf->search(htbl, hash, key, copy, &update) )
+	{
+		return RET_UPDATE;
+	}
+
+	if( callback && callback->init )
+	{
+		callback->init(value, callback->userData);
+	}
+	if( copy && copy->value )
+	{
+		htbl->ops.assignValue(value, copy->value);
+		copy->expired = timeout;
+	}
+	return StageInsert(htbl, stage, hash, key, value, timeout, 1);
+}
+
+/*remove the staged node of key, the objects go back through expireFunc as a deleted node*/
+static int StageRemove(struct hashTable *htbl, struct HashStage *stage, unsigned int hash, void *key, void *copy)
+{
+	struct HashNodeCopy *cp = (struct HashNodeCopy*)copy;
+	struct HashStageEntry *e = NULL;
+	struct HashStageEntry *last = NULL;
+	int i = StageSearch(htbl, stage, hash, key);
+
+	if( i < 0 )
+	{
+		return RET_FAILED;
+	}
+
+	e = &stage->entry[i];
+	last = &stage->entry[stage->count-1];
+	if( cp && cp->value )
+	{
+		htbl->ops.assignValue(e->value, cp->value);
+		cp->expired = e->timeout;
+	}
+	HashExpireNode(htbl, e->key, e->value, HashOwner());
+	if( e != last )
+	{
+		stage->hash[i] = stage->hash[stage->count-1];
+		e->timeout = last->timeout;
+		if( htbl->mode == HASH_STRATEGY_INLINE )
+		{
+			memcpy(e->key, last->key, htbl->ops.keySize + htbl->ops.valueSize);
+		}
+		else
+		{
+			e->key = last->key;
+			e->value = last->value;
+		}
+	}
+	stage->count--;
+
+	return 0;
+}
+
+void *hash_table_find(struct hashTable *htbl, void *data, int dLen, void *key, void *copy, struct UpdateCallBack *callback)
+{
+	struct HashStage *stage = NULL;
+	unsigned int hash = 0;
+	void *value = NULL;
+
+	if( !htbl || !key || !dLen )
+	{
+		return NULL;
+	}
+
+	hash = htbl->ops.hash(data, dLen, key);
+	if( (stage = HashStageOf(htbl)) && (value = StageFind(htbl, stage, hash, key, copy, callback)) )
+	{
+		return value;
+	}
+	if( HashFilterMiss(htbl, hash) )
+	{
+		return NULL;
+	}
+	return htbl->inf->search(htbl, hash, key, copy, callback);
+}
+
+int hash_table_update(struct hashTable *htbl, void *data, int dLen, void *key, struct UpdateCallBack *callback)
+{
+	struct HashStage *stage = NULL;
+	unsigned int hash = 0;
+	void *value = NULL;
+	if( !htbl || !key || !dLen )
+	{
+		return -1;
+	}
+
+	hash = htbl->ops.hash(data, dLen, key);
+	if( (stage = HashStageOf(htbl)) && StageFind(htbl, stage, hash, key, NULL, callback) )
+	{
+		return 0;
+	}
+	if( HashFilterMiss(htbl, hash) )
+	{
+		return -1;
+	}
+	value = htbl->inf->search(htbl, hash, key, NULL, callback);
+	return value?0:-1;
+}
+
+int hash_table_insert(struct hashTable *htbl, void *data, int dLen, void *key, void *value, uint64_t timeout)
+{
+	struct HashStage *stage = NULL;
+	unsigned int hash = 0;
+	int ret = 0;
+
+	if( !htbl || !key || !value || !dLen )
+	{
+		return -1;
+	}
+
+	hash = htbl->ops.hash(data, dLen, key);
+	if( (stage = HashStageOf(htbl)) )
+	{
+		return StageInsert(htbl, stage, hash, key, value, timeout, 0);
+	}
+	HashFilterAdd(htbl, hash);
+	ret = htbl->inf->insert(htbl, hash, key, value, timeout);
+	HashStatInsert(htbl, ret);
+
+	return ret;
+}
+
+int hash_table_insert_key(struct hashTable *htbl, void *key, void *value, uint64_t timeout)
+{
+	struct HashStage *stage = NULL;
+	unsigned int hash = 0;
+	int ret = 0;
+
+	if( !htbl || !key || !value || !htbl->ops.keyHashFunc )
+	{
+		return -1;
+	}
+
+	hash = htbl->ops.keyHashFunc(key);
+	if( (stage = HashStageOf(htbl)) )
+	{
+		return StageInsert(htbl, stage, hash, key, value, timeout, 0);
+	}
+	HashFilterAdd(htbl, hash);
+	ret = htbl->inf->insert(htbl, hash, key, value, timeout);
+	HashStatInsert(htbl, ret);
+
+	return ret;
+}
+
+int hash_table_upsert(struct hashTable *htbl, void *data, int dLen, void *key, void *value, uint64_t timeout,
+		struct UpsertCallBack *callback, struct HashNodeCopy *copy)
+{
+	struct HashStage *stage = NULL;
+	unsigned int hash = 0;
+	int ret = 0;
+
+	if( !htbl || !key || !value || !dLen )
+	{
+		return RET_FAILED;
+	}
+
+	hash = htbl->ops.hash(data, dLen, key);
+	if( (stage = HashStageOf(htbl)) )
+	{
+		return StageUpsert(htbl, stage, hash, key, value, timeout, callback, copy);
+	}
+	HashFilterAdd(htbl, hash);
+	ret = htbl->inf->upsert(htbl, hash, key, value, timeout, callback, copy);
+	HashStatInsert(htbl, ret);
+
+	return ret;
+}
+
+/*
+ * Hash the whole burst first, then prefetch every target bucket, then what the buckets point to,
+ * so the cache misses of the burst overlap instead of being paid one key after another. With a
+ * filter and probe set, the filter blocks are prefetched first and only the keys passing it are
+ * probed, the bit of the others is cleared in probe.
+ */
+static void HashBulkPrefetch(struct hashTable *htbl, void **data, int *dLen, void **key, unsigned int num, unsigned int *hash, uint64_t *probe)
+{
+	uint64_t mask = 0;
+	unsigned int i = 0;
+
+	if( htbl->filterMem && probe )
+	{
+		for( i = 0; i < num; i++)
+		{
+			hash[i] = htbl->ops.hash(data[i], dLen[i], key[i]);
+			HashFilterPrefetch(htbl, hash[i]);
+		}
+		for( i = 0; i < num; i++)
+		{
+			if( !HashFilterMiss(htbl, hash[i]) )
+			{
+				mask |= 1ULL<<i;
+				htbl->inf->prefetch(htbl, hash[i], 0);
+			}
+		}
+		for( i = 0; i < num; i++)
+		{
+			if( mask & (1ULL<<i) )
+			{
+				htbl->inf->prefetch(htbl, hash[i], 1);
+			}
+		}
+		*probe = mask;
+		return;
+	}
+
+	for( i = 0; i < num; i++)
+	{
+		hash[i] = htbl->ops.hash(data[i], dLen[i], key[i]);
+		htbl->inf->prefetch(htbl, hash[i], 0);
+	}
+	for( i = 0; i < num; i++)
+	{
+		htbl->inf->prefetch(htbl, hash[i], 1);
+	}
+	if( probe )
+	{
+		*probe = (num < 64) ? (1ULL<<num) - 1 : ~0ULL;
+	}
+}
+
+int hash_table_find_bulk(struct hashTable *htbl, void **data, int *dLen, void **key, struct HashNodeCopy *copy, unsigned int num, uint64_t *hitMask)
+{
+	struct HashStage *stage = NULL;
+	unsigned int hash[HASH_BULK_MAX];
+	unsigned int i = 0;
+	int hits = 0;
+	uint64_t mask = 0;
+	uint64_t probe = 0;
+
+	if( !htbl || !data || !dLen || !key || !hitMask || num > HASH_BULK_MAX )
+	{
+		return -1;
+	}
+
+	HashBulkPrefetch(htbl, data, dLen, key, num, hash, &probe);
+	stage = HashStageOf(htbl);
+	for( i = 0; i < num; i++)
+	{
+		if( stage && StageFind(htbl, stage, hash[i], key[i], copy?&copy[i]:NULL, NULL) )
+		{
+			mask |= 1ULL<<i;
+			hits++;
+		}
+		else if( (probe & (1ULL<<i)) && htbl->inf->search(htbl, hash[i], key[i], copy?&copy[i]:NULL, NULL) )
+		{
+			mask |= 1ULL<<i;
+			hits++;
+		}
+	}
+	*hitMask = mask;
+
+	return hits;
+}
+
+int hash_table_insert_bulk(struct hashTable *htbl, void **data, int *dLen, void **key, void **value, uint64_t timeout, unsigned int num, int *ret)
+{
+	struct HashStage *stage = NULL;
+	unsigned int hash[HASH_BULK_MAX];
+	unsigned int i = 0;
+	int inserted = 0;
+
+	if( !htbl || !data || !dLen || !key || !value || !ret || num > HASH_BULK_MAX )
+	{
+		return -1;
+	}
+
+	/*a bulk goes to the table at once, the nodes staged before it must not overwrite it later*/
+	if( (stage = HashStageOf(htbl)) )
+	{
+		HashStageFlush(htbl, stage);
+	}
+	HashBulkPrefetch(htbl, data, dLen, key, num, hash, NULL);
+	for( i = 0; i < num; i++)
+	{
+		HashFilterAdd(htbl, hash[i]);
+		ret[i] = htbl->inf->insert(htbl, hash[i], key[i], value[i], timeout);
+		HashStatInsert(htbl, ret[i]);
+		if( ret[i] != RET_FAILED )
+		{
+			inserted++;
+		}
+	}
+
+	return inserted;
+}
+
+/*a key staged by the calling lcore may be in the table too, the staged node is the newer one*/
+static int HashDelete(struct hashTable *htbl, unsigned int hash, void *key, void *copy)
+{
+	struct HashStage *stage = HashStageOf(htbl);
+	int ret = RET_FAILED;
+
+	if( !HashFilterMiss(htbl, hash) )
+	{
+		ret = htbl->inf->remove(htbl, hash, key, copy);
+	}
+	if( stage && StageRemove(htbl, stage, hash, key, copy) == 0 )
+	{
+		ret = 0;
+	}
+	if( ret == 0 )
+	{
+		HASH_STAT_INC(htbl, deletion);
+	}
+
+	return ret;
+}
+
+int hash_table_delete(struct hashTable *htbl, void *data, int dLen, void *key, void *copy)
+{
+	unsigned int hash = 0;
+
+	if( !htbl || !key || !dLen || !htbl->inf->remove )
+	{
+		return RET_FAILED;
+	}
+
+	hash = htbl->ops.hash(data, dLen, key);
+	return HashDelete(htbl, hash, key, copy);
+}
+
+int hash_table_sig(struct hashTable *htbl, void *data, int dLen, void *key, struct HashSig *sig)
 {
-	return malloc(size);
+	if( !htbl || !key || !dLen || !sig )
+	{
+		return -1;
+	}
+
+	sig->hash = htbl->ops.hash(data, dLen, key);
+	return 0;
 }
 
-static void HashDefaultFree(void *ptr, int len)
+void hash_table_prefetch_sig(struct hashTable *htbl, const struct HashSig *sig)
 {
-	free(ptr);
+	if( htbl && sig )
+	{
+		HashFilterPrefetch(htbl, sig->hash);
+		htbl->inf->prefetch(htbl, sig->hash, 0);
+	}
 }
 
-static int Init(struct hashTable *htbl, int size)
+void *hash_table_find_with_sig(struct hashTable *htbl, const struct HashSig *sig, void *key, void *copy, struct UpdateCallBack *callback)
 {
-	int i = 0;
+	struct HashStage *stage = NULL;
+	void *value = NULL;
 
-	htbl->capacity = size;
-	htbl->bucketSize = htbl->factor*size;
-	htbl->bucket = htbl->ops.mallocFunc(sizeof(struct ListElem)*htbl->bucketSize);
-	if( !htbl->bucket )
+	if( !htbl || !sig || !key )
 	{
-		printf("Malloc bucket failed.\n");
-		return -1;
+		return NULL;
 	}
-	memset(htbl->bucket, 0x00, sizeof(struct ListElem)*htbl->bucketSize);
-	for( ; i < htbl->bucketSize; i++)
+	if( (stage = HashStageOf(htbl)) && (value = StageFind(htbl, stage, sig->hash, key, copy, callback)) )
 	{
-		rte_rwlock_init(&(htbl->bucket[i].rwlock));
+		return value;
+	}
+	if( HashFilterMiss(htbl, sig->hash) )
+	{
+		return NULL;
 	}
-	htbl->st.totalMem = sizeof(*htbl) + sizeof(struct ListElem)*htbl->bucketSize;
 
-	return 0;
+	return htbl->inf->search(htbl, sig->hash, key, copy, callback);
 }
 
-static int InsertElemSelfExpired(struct hashTable *htbl, void *data, int dLen, void *key, void *value, uint64_t timeout)
+int hash_table_insert_with_sig(struct hashTable *htbl, const struct HashSig *sig, void *key, void *value, uint64_t timeout)
 {
-	int idx = 0;
-	struct ListElem *elem = NULL;
-	uint64_t currentTime = 0;
-	int count = 0;
-	int ret = RET_FAILED;
-	uint64_t expired = 0;
-
-	expired = timeout;
-	idx = htbl->ops.hash(data, dLen, key)%htbl->bucketSize;
-	elem = &htbl->bucket[idx];
+	struct HashStage *stage = NULL;
+	int ret = 0;
 
-	while( count < htbl->probeStep )
+	if( !htbl || !sig || !key || !value )
 	{
-		rte_rwlock_write_lock(&elem->rwlock);
-		if( elem->status == STATUS_AVAILABLE )
-		{
-			elem->key = key;
-			elem->value = value;
-			elem->timeout = expired;
-			elem->status = STATUS_USE;
-			ret = RET_NEW;
-			rte_rwlock_write_unlock(&elem->rwlock);
-			break;
-		}
-
-		if( (elem->status == STATUS_USE) && (currentTime >= elem->timeout || htbl->ops.cmp(elem->key, key)) )
-		{
-			htbl->ops.assignKey(key, elem->key);
-			htbl->ops.assignValue(value, elem->value);
-			elem->timeout = expired;
-			ret = RET_OCCUPY;
-			rte_rwlock_write_unlock(&elem->rwlock);
-			break;
-		}
-		rte_rwlock_write_unlock(&elem->rwlock);
-
-		elem++;
-		count++;
-		rte_atomic32_inc(&htbl->st.collision);
+		return -1;
 	}
-
-	if( ret == RET_FAILED )
+	if( (stage = HashStageOf(htbl)) )
 	{
-		rte_atomic32_inc(&htbl->st.failed);
-		goto FAILED;
+		return StageInsert(htbl, stage, sig->hash, key, value, timeout, 0);
 	}
 
-	return ret;
+	HashFilterAdd(htbl, sig->hash);
+	ret = htbl->inf->insert(htbl, sig->hash, key, value, timeout);
+	HashStatInsert(htbl, ret);
 
-FAILED:
 	return ret;
 }
 
-static void *FindElemSelfExpired(struct hashTable *htbl, void *data, int dLen, void *key, void *copy, struct UpdateCallBack *callback)
+int hash_table_update_with_sig(struct hashTable *htbl, const struct HashSig *sig, void *key, struct UpdateCallBack *callback)
 {
-	int idx = 0;
-	struct ListElem *elem = NULL;
-	int count = 0;
-	int find = 0;
-	uint64_t currentTime = 0;
-	struct HashNodeCopy *cp = NULL;
-
-	idx = htbl->ops.hash(data, dLen, key)%htbl->bucketSize;
-	elem = &htbl->bucket[idx];
-	currentTime = rte_rdtsc();
-	cp = (struct HashNodeCopy*)copy;
+	struct HashStage *stage = NULL;
 
-	while( count <= htbl->probeStep )
+	if( !htbl || !sig || !key )
 	{
-		rte_rwlock_read_lock(&elem->rwlock);
-		if( (elem->status == STATUS_USE) && 
-				(htbl->ops.cmp(elem->key, key) == 1) &&
-				(currentTime < elem->timeout) )
-		{
-			find = 1;
-			if( cp && cp->value )
-			{
-				htbl->ops.assignValue(elem->value, cp->value);
-				cp->expired = elem->timeout;
-			}
-			rte_rwlock_read_unlock(&elem->rwlock);
-			break;
-		}
-		rte_rwlock_read_unlock(&elem->rwlock);
-
-		elem++;
-		count++;
+		return -1;
 	}
-
-	if( callback && callback->update && find )
+	if( (stage = HashStageOf(htbl)) && StageFind(htbl, stage, sig->hash, key, NULL, callback) )
+	{
+		return 0;
+	}
+	if( HashFilterMiss(htbl, sig->hash) )
 	{
-		rte_rwlock_write_lock(&elem->rwlock);
-		callback->update(elem->value, callback->userData);	
-		rte_rwlock_write_unlock(&elem->rwlock);
+		return -1;
 	}
-	return (find?elem:NULL);
+
+	return htbl->inf->search(htbl, sig->hash, key, NULL, callback)?0:-1;
 }
 
-static int InsertElemLRU(struct hashTable *htbl, void *data, int dLen, void *key, void *value, uint64_t timeout)
+int hash_table_upsert_with_sig(struct hashTable *htbl, const struct HashSig *sig, void *key, void *value, uint64_t timeout,
+		struct UpsertCallBack *callback, struct HashNodeCopy *copy)
 {
-	int idx = 0;
-	struct ListElem *elem = NULL;
-	uint64_t currentTime = 0;
-	int count = 0;
-	int ret = RET_FAILED;
-	struct ListElem *oldest = NULL;
-
-	idx = htbl->ops.hash(data, dLen, key)%htbl->bucketSize;
-	elem = &htbl->bucket[idx];
-	oldest = elem;
+	struct HashStage *stage = NULL;
+	int ret = 0;
 
-	while( count < htbl->probeStep )
+	if( !htbl || !sig || !key || !value )
 	{
-		rte_rwlock_write_lock(&elem->rwlock);
-		if( elem->status == STATUS_AVAILABLE )
-		{
-			elem->key = key;
-			elem->value = value;
-			elem->timeout = timeout;
-			elem->status = STATUS_USE;
-			ret = RET_NEW;
-			rte_rwlock_write_unlock(&elem->rwlock);
-			break;
-		}
+		return RET_FAILED;
+	}
+	if( (stage = HashStageOf(htbl)) )
+	{
+		return StageUpsert(htbl, stage, sig->hash, key, value, timeout, callback, copy);
+	}
 
-		if( (elem->status == STATUS_USE) && htbl->ops.cmp(elem->key, key) )
-		{
-			htbl->ops.assignKey(key, elem->key);
-			htbl->ops.assignValue(value, elem->value);
-			elem->timeout = timeout;
-			ret = RET_OCCUPY;
-			rte_rwlock_write_unlock(&elem->rwlock);
-			break;
-		}
+	HashFilterAdd(htbl, sig->hash);
+	ret = htbl->inf->upsert(htbl, sig->hash, key, value, timeout, callback, copy);
+	HashStatInsert(htbl, ret);
 
-		if( elem->timeout < oldest->timeout )
-		{
-			oldest = elem;
-		}
-		rte_rwlock_write_unlock(&elem->rwlock);
+	return ret;
+}
 
-		elem++;
-		count++;
-		rte_atomic32_inc(&htbl->st.collision);
+int hash_table_delete_with_sig(struct hashTable *htbl, const struct HashSig *sig, void *key, void *copy)
+{
+	if( !htbl || !sig || !key || !htbl->inf->remove )
+	{
+		return RET_FAILED;
 	}
 
-	if( ret == RET_FAILED )
+	return HashDelete(htbl, sig->hash, key, copy);
+}
+
+unsigned int hash_table_slots(struct hashTable *htbl)
+{
+	if( !htbl )
 	{
-		rte_rwlock_write_lock(&oldest->rwlock);
-		htbl->ops.assignKey(key, oldest->key);
-		htbl->ops.assignValue(value, oldest->value);
-		rte_rwlock_write_unlock(&oldest->rwlock);
-		ret = RET_OCCUPY;
+		return 0;
 	}
-
-	return ret;
+	/*the list arrays have a tail for the probe window of the last buckets*/
+	if( htbl->list )
+	{
+		return htbl->list->total;
+	}
+	return htbl->bucketSize;
 }
 
-static void *FindElemLRU(struct hashTable *htbl, void *data, int dLen, void *key, void *copy, struct UpdateCallBack *callback)
+int hash_table_iterate(struct hashTable *htbl, unsigned int start, unsigned int end, fpVisit visit, void *userData, unsigned int *next)
 {
-	int idx = 0;
-	struct ListElem *elem = NULL;
-	int count = 0;
-	int find = 0;
-	uint64_t currentTime = 0;
-	struct HashNodeCopy *cp = NULL;
+	unsigned int stopped = 0;
+	int visited = 0;
 
-	idx = htbl->ops.hash(data, dLen, key)%htbl->bucketSize;
-	elem = &htbl->bucket[idx];
-	currentTime = rte_rdtsc();
-	cp = (struct HashNodeCopy*)copy;
+	if( !htbl || !visit || start > end )
+	{
+		return -1;
+	}
 
-	while( count <= htbl->probeStep )
+	visited = htbl->inf->iterate(htbl, start, end, visit, userData, &stopped);
+	if( next )
 	{
-		rte_rwlock_read_lock(&elem->rwlock);
-		if( (elem->status == STATUS_USE) && 
-				(htbl->ops.cmp(elem->key, key) == 1) )
-		{
-			find = 1;
-			if( cp && cp->value )
-			{
-				htbl->ops.assignValue(elem->value, cp->value);
-				cp->expired = elem->timeout;
-			}
-			elem->timeout = currentTime;
-			rte_rwlock_read_unlock(&elem->rwlock);
-			break;
-		}
-		rte_rwlock_read_unlock(&elem->rwlock);
+		*next = stopped;
+	}
+	return visited;
+}
 
-		elem++;
-		count++;
+int hash_table_resize(struct hashTable *htbl, unsigned int capacity)
+{
+	if( !htbl || !capacity || !htbl->inf->resize )
+	{
+		return -1;
 	}
 
-	if( callback && callback->update && find )
+	return htbl->inf->resize(htbl, capacity);
+}
+
+int hash_table_set_resize(struct hashTable *htbl, unsigned int minCapacity, unsigned int maxCapacity)
+{
+	if( !htbl || !htbl->inf->resize || minCapacity > maxCapacity )
 	{
-		rte_rwlock_write_lock(&elem->rwlock);
-		callback->update(elem->value, callback->userData);	
-		rte_rwlock_write_unlock(&elem->rwlock);
+		return -1;
 	}
-	return (find?elem:NULL);
+
+	htbl->minCapacity = minCapacity?minCapacity:htbl->initCapacity;
+	htbl->maxCapacity = maxCapacity;
+	return 0;
 }
 
-struct HashInterface gHashInf[HASH_STRATEGY_MAX] =
+int hash_table_set_max_displacement(struct hashTable *htbl, unsigned int maxDisplacement)
 {
-	[HASH_STRATEGY_SELF_EXPIRED] = 
+	if( !htbl || htbl->mode != HASH_STRATEGY_ROBINHOOD || !maxDisplacement ||
+			maxDisplacement >= htbl->bucketSize || maxDisplacement > ROBIN_DIST_LIMIT )
 	{
-		.insert = InsertElemSelfExpired,
-		.search = FindElemSelfExpired
-	},
+		return -1;
+	}
 
-	[HASH_STRATEGY_LRU] = 
+	htbl->maxDisplacement = maxDisplacement;
+	return 0;
+}
+
+int hash_table_expire(struct hashTable *htbl, unsigned int budget)
+{
+	if( !htbl || !htbl->inf->expire )
 	{
-		.insert = InsertElemLRU,
-		.search = FindElemLRU
+		return 0;
 	}
-};
 
-void *hash_table_find(struct hashTable *htbl, void *data, int dLen, void *key, void *copy, struct UpdateCallBack *callback)
+	return htbl->inf->expire(htbl, budget);
+}
+
+int hash_table_reclaim(struct hashTable *htbl, unsigned int owner, unsigned int want, unsigned int budget)
 {
-	struct ListElem *elem = NULL;
-	if( !htbl || !key || !dLen )
+	if( !htbl || !want || !htbl->inf->reclaim )
 	{
-		return NULL;
+		return 0;
 	}
 
-	elem = htbl->inf->search(htbl, data, dLen, key, copy, callback);
-	return elem?elem->value:NULL;
+	return htbl->inf->reclaim(htbl, owner, want, budget);
 }
 
-int hash_table_update(struct hashTable *htbl, void *data, int dLen, void *key, struct UpdateCallBack *callback)
+int hash_table_invalidate_by_ip(struct hashTable *htbl, uint32_t ip, unsigned int prefixLen)
 {
-	struct ListElem *elem = NULL;
-	if( !htbl || !key || !dLen )
+	if( !htbl || !(htbl->ops.flags & HASH_TABLE_F_IP_INDEX) || !htbl->inf->invalidate || prefixLen > 32 )
 	{
 		return -1;
 	}
 
-	elem = htbl->inf->search(htbl, data, dLen, key, NULL, callback);
-	return elem?0:-1;
+	return htbl->inf->invalidate(htbl, ip, prefixLen);
 }
 
-int hash_table_insert(struct hashTable *htbl, void *data, int dLen, void *key, void *value, uint64_t timeout)
+void hash_table_maintain(struct hashTable *htbl)
 {
-	if( !htbl || !key || !value || !dLen )
+	struct HashStage *stage = NULL;
+	unsigned int lcore = rte_lcore_id();
+
+	if( !htbl )
 	{
-		return -1;
+		return;
+	}
+
+	if( lcore < RTE_MAX_LCORE )
+	{
+		htbl->qs[lcore].epoch = htbl->epoch;
+		htbl->qs[lcore].online = 1;
+		rte_smp_mb();
+	}
+	if( htbl->inf->maintain )
+	{
+		htbl->inf->maintain(htbl);
+	}
+	FilterMaintain(htbl);
+	SketchMaintain(htbl);
+	if( (stage = HashStageOf(htbl)) && stage->count && rte_rdtsc() - stage->since >= htbl->stageAge )
+	{
+		HashStageFlush(htbl, stage);
 	}
+}
+
+void hash_table_flush(struct hashTable *htbl)
+{
+	struct HashStage *stage = NULL;
 
-	return htbl->inf->insert(htbl, data, dLen, key, value, timeout);
+	if( htbl && (stage = HashStageOf(htbl)) )
+	{
+		HashStageFlush(htbl, stage);
+	}
 }
 
 struct hashTable *hash_table_create(unsigned int capacity, enum HASH_STRATEGY mode, struct HashTableOps *ops)
@@ -357,6 +5093,32 @@ struct hashTable *hash_table_create(unsigned int capacity, enum HASH_STRATEGY mo
 		printf("Unsupported mode!\n");
 		goto FAILED;
 	}
+	if( mode == HASH_STRATEGY_INLINE && (!ops->keySize || !ops->valueSize) )
+	{
+		printf("keySize/valueSize must be provided for inline mode!\n");
+		goto FAILED;
+	}
+	if( (ops->flags & HASH_TABLE_F_FILTER) && !ops->keyHashFunc )
+	{
+		printf("keyHashFunc must be provided for the filter!\n");
+		goto FAILED;
+	}
+	if( (ops->flags & HASH_TABLE_F_ADMISSION) && mode != HASH_STRATEGY_LRU && mode != HASH_STRATEGY_CLOCK )
+	{
+		printf("Admission is only supported by the LRU and CLOCK modes!\n");
+		goto FAILED;
+	}
+	if( (ops->flags & HASH_TABLE_F_SOA_META) && mode != HASH_STRATEGY_SELF_EXPIRED && mode != HASH_STRATEGY_LRU && mode != HASH_STRATEGY_CLOCK )
+	{
+		printf("Side arrays of metadata are only supported by the list modes!\n");
+		goto FAILED;
+	}
+	if( (ops->flags & HASH_TABLE_F_IP_INDEX) && (!ops->keyIpFunc ||
+				(mode != HASH_STRATEGY_SELF_EXPIRED && mode != HASH_STRATEGY_LRU && mode != HASH_STRATEGY_CLOCK)) )
+	{
+		printf("The index of addresses needs keyIpFunc and a list mode!\n");
+		goto FAILED;
+	}
 
 	if( !ops->mallocFunc )
 	{
@@ -366,25 +5128,49 @@ struct hashTable *hash_table_create(unsigned int capacity, enum HASH_STRATEGY mo
 	{
 		ops->freeFunc = HashDefaultFree;
 	}
-	htbl = ops->mallocFunc(sizeof(struct hashTable));
+	if( ops->mallocSocketFunc )
+	{
+		htbl = ops->mallocSocketFunc(sizeof(struct hashTable), ops->socket);
+	}
+	else
+	{
+		htbl = ops->mallocFunc(sizeof(struct hashTable));
+	}
 
 	if( !htbl )
 	{
 		printf("Malloc Hash Table failed\n");
 		goto FAILED;
 	}
+	memset(htbl, 0x00, sizeof(struct hashTable));
 	htbl->factor = 3;
 	htbl->probeStep = PROBE_COUNT;
 	htbl->mode = mode;
 	htbl->ops = *ops;
 	htbl->inf = &gHashInf[mode];
 
-	ret = Init(htbl, capacity);
+	ret = htbl->inf->init(htbl, capacity);
 	if( ret < 0 )
 	{
 		printf("Init Hash Table failed\n");
 		goto FAILED;
 	}
+	if( (ops->flags & HASH_TABLE_F_FILTER) && InitFilter(htbl, capacity) < 0 )
+	{
+		printf("Malloc hash filter failed\n");
+		goto FAILED;
+	}
+	if( (ops->flags & HASH_TABLE_F_WRITE_COMBINE) && InitStage(htbl) < 0 )
+	{
+		printf("Malloc write-combining stages failed\n");
+		goto FAILED;
+	}
+	htbl->stageAge = rte_get_tsc_hz()*HASH_STAGE_FLUSH_US/1000000;
+	if( (ops->flags & HASH_TABLE_F_ADMISSION) && InitSketch(htbl, capacity) < 0 )
+	{
+		printf("Malloc admission sketch failed\n");
+		goto FAILED;
+	}
 
 	return htbl;
 
@@ -403,40 +5189,70 @@ void hash_table_destroy(struct hashTable *htbl)
 		return;
 	}
 
-    htbl->ops.freeFunc(htbl->bucket, sizeof(struct ListElem)*htbl->bucketSize);	
+	htbl->inf->release(htbl);
+	ReleaseFilter(htbl);
+	ReleaseStage(htbl);
+	ReleaseSketch(htbl);
 	htbl->ops.freeFunc(htbl, sizeof(*htbl));
 }
 
-void hash_table_assess(struct hashTable *htbl)
+int hash_table_stats(struct hashTable *htbl, struct HashTableStats *stats)
 {
+	struct HashLcoreStats *lcore = NULL;
 	unsigned int i = 0;
+	int j = 0;
+
+	if( !htbl || !stats )
+	{
+		return -1;
+	}
+
+	memset(stats, 0x00, sizeof(*stats));
+	for( ; i <= RTE_MAX_LCORE; i++)
+	{
+		lcore = &htbl->stats[i];
+		stats->insert += lcore->insert;
+		stats->occupy += lcore->occupy;
+		stats->hit += lcore->hit;
+		stats->miss += lcore->miss;
+		stats->failed += lcore->failed;
+		stats->collision += lcore->collision;
+		stats->eviction += lcore->eviction;
+		stats->expiration += lcore->expiration;
+		stats->deletion += lcore->deletion;
+		stats->filtered += lcore->filtered;
+		stats->staged += lcore->staged;
+		stats->rejected += lcore->rejected;
+		for( j = 0; j < HASH_STATS_PROBE_MAX; j++)
+		{
+			stats->probe[j] += lcore->probe[j];
+		}
+	}
+	stats->capacity = htbl->capacity;
+	stats->bucketSize = htbl->bucketSize;
+	stats->totalMem = htbl->st.totalMem;
+
+	return 0;
+}
+
+void hash_table_set_owner(unsigned int lcore)
+{
+	tHashOwner = lcore;
+}
+
+void hash_table_assess(struct hashTable *htbl)
+{
+	struct HashTableStats stats;
 	int cnt = 0;
 	int timeout = 0;
 	int available = 0;
 	uint64_t current = 0;
 
 	current = rte_rdtsc();
-	for( ; i < htbl->bucketSize; i++)
-	{
-		if( htbl->bucket[i].status == STATUS_USE )
-		{
-			cnt++;
-			if( htbl->ops.assessFunc )
-			{
-				htbl->ops.assessFunc(htbl->bucket[i].value);
-			}
-			if( htbl->bucket[i].timeout < current )
-			{
-				timeout++;
-			}
-		}
-		else if( htbl->bucket[i].status == STATUS_AVAILABLE )
-		{
-			available++;
-		}
-	}
+	htbl->inf->travel(htbl, current, &cnt, &timeout, &available);
 
-	printf("Hash Insert Failed:%d. Collision:%d\n", rte_atomic32_read(&(htbl->st.failed)), rte_atomic32_read(&(htbl->st.collision)));
+	hash_table_stats(htbl, &stats);
+	printf("Hash Insert Failed:%lu. Collision:%lu\n", (unsigned long)stats.failed, (unsigned long)stats.collision);
 	printf("Hash capacity:%d. Current cnt:%d. Expired cnt:%d.\n", htbl->capacity, cnt, timeout);
 	printf("Hash total usage rate:%f\n", (double)cnt/(double)htbl->bucketSize);
 	printf("Hash usage rate:%f\n", (double)(cnt-timeout)/(double)htbl->bucketSize);
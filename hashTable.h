@@ -24,11 +24,98 @@ extern "C" {
 #define RET_FAILED -1
 #define RET_NEW 0
 #define RET_OCCUPY 1
+/*hash_table_upsert found the key and updated its node*/
+#define RET_UPDATE 2
+
+/*
+ * The table is only ever accessed by one lcore, lookups and updates take no lock. Expiry,
+ * maintenance and resize must be driven by that lcore too.
+ */
+#define HASH_TABLE_F_SINGLE_OWNER 0x1
+/*
+ * Keep a blocked Bloom filter of the keys in front of the table, about 10 bits per node of
+ * capacity. A lookup or delete of a key the filter never saw costs one cache line instead of
+ * a probe, so the misses of a flood of new keys stay out of the table. Inserts set the bits
+ * of their key; the bits of expired and deleted nodes go away when hash_table_maintain
+ * rebuilds the filter in the background. HashTableOps keyHashFunc must be provided.
+ */
+#define HASH_TABLE_F_FILTER 0x2
+/*
+ * Stage the inserts and upserts of new keys in a small buffer of the calling lcore instead of
+ * writing the table. The buffer is flushed to the table sorted by bucket when it is full, by
+ * hash_table_maintain once its oldest node is a few hundred microseconds old, and by
+ * hash_table_flush. Lookups, updates and deletes of the same lcore see the staged nodes, other
+ * lcores, iteration, expiry and snapshots only see them once flushed. An upsert of a new key does
+ * not lock the table, so two lcores may both stage it and both get RET_NEW: the later flush finds
+ * the node of the key and leaves it as it is, the way an upsert of an existing key without update
+ * does. A staged insert overwrites the node of its key like hash_table_insert. The key/value
+ * objects of a staged node which the flush could not insert, found already in the table or copied
+ * onto another node are given back through HashTableOps expireFunc, or evictFunc with the
+ * flushing lcore as owner.
+ */
+#define HASH_TABLE_F_WRITE_COMBINE 0x4
+/*
+ * TinyLFU admission for HASH_STRATEGY_LRU and HASH_STRATEGY_CLOCK. Every lookup and insert counts
+ * the key in a count-min sketch of 4-bit counters, about 4 bytes per node of capacity, halved by
+ * hash_table_maintain after 10 accesses per node of capacity. An insert which would evict a live
+ * node fails instead, unless its key was seen more often than the victim, so a flood of keys seen
+ * once no longer pushes the frequently seen ones out.
+ */
+#define HASH_TABLE_F_ADMISSION 0x8
+/*
+ * Keep the status and a coarse expiry tick of each slot of the list strategies in dense side
+ * arrays, 5 bytes per slot next to the 40 bytes of the slot. The expiry sweep, hash_table_iterate,
+ * hash_table_assess and the load sampling of the online resize scan these with AVX2, 32 slots at
+ * a time, and only touch the slots which are used or whose expiry tick was reached. A tick is
+ * about a millisecond, expiry within the current tick is still checked against the full timeout.
+ */
+#define HASH_TABLE_F_SOA_META 0x10
+/*
+ * Index the nodes of the list strategies by the IPv4 address HashTableOps keyIpFunc returns for
+ * their key, so hash_table_invalidate_by_ip finds the nodes of an address or a subnet without
+ * walking the table. Each slot is chained under the /24 of its address, about 14 bytes per slot.
+ */
+#define HASH_TABLE_F_IP_INDEX 0x20
+
+/*number of buckets of the probe length histogram*/
+#define HASH_STATS_PROBE_MAX 8
+
+/*maximum number of keys of a bulk operation*/
+#define HASH_BULK_MAX 64
 
 enum HASH_STRATEGY
 {
 	HASH_STRATEGY_SELF_EXPIRED,
 	HASH_STRATEGY_LRU,
+	/*
+	 * Self-expired nodes kept in 8-way buckets with 16-bit signatures. Each key has two candidate
+	 * buckets and insert displaces existing nodes to their alternative bucket when both are full,
+	 * so the table runs at ~90% load and a lookup touches at most two bucket cache lines.
+	 */
+	HASH_STRATEGY_CUCKOO,
+	/*
+	 * Self-expired nodes whose key and value are copied into the slot, so a probe costs one
+	 * cache miss instead of chasing the key and value pointers. Slots are packed into cache
+	 * line sized probe groups and the group count is a power of two. HashTableOps keySize and
+	 * valueSize must be set, keys are compared bytewise. The table never keeps the key/value
+	 * passed to insert, so the caller can release them whatever the return value is.
+	 */
+	HASH_STRATEGY_INLINE,
+	/*
+	 * Self-expired nodes evicted by CLOCK when the probe window is full. A lookup sets the
+	 * reference bit of the node only if it is clear, so hot nodes are not written on each hit
+	 * as HASH_STRATEGY_LRU does. Insert clears the bits it passes and evicts the first node
+	 * not referenced since, instead of the oldest access time of the window.
+	 */
+	HASH_STRATEGY_CLOCK,
+	/*
+	 * Self-expired nodes kept by Robin Hood linear probing. Insert moves the nodes closer to their
+	 * home slot out of the way of farther ones, so probe lengths stay short and even and the table
+	 * runs at ~85% load. A lookup stops at the first node closer to its home slot than the key
+	 * would be. Insert fails instead of placing a node farther than the maximum displacement, see
+	 * hash_table_set_max_displacement.
+	 */
+	HASH_STRATEGY_ROBINHOOD,
 	HASH_STRATEGY_MAX
 };
 
@@ -37,15 +124,32 @@ struct hashTable;
 typedef int (*fpCompare)(void *key1, void *key2);
 /*calculate the hash info of data and stored in key*/
 typedef int (*fpHash)(void *data, int dLen, void *key);
+/*return the hash value fpHash computed when it filled key, from key alone*/
+typedef unsigned int (*fpKeyHash)(void *key);
 typedef void* (*fpMalloc)(size_t size);
+/*allocate memory on the NUMA node socket*/
+typedef void* (*fpMallocSocket)(size_t size, int socket);
 typedef void (*fpFree)(void *ptr, int len);
 typedef void (*fpAssess)(void *data);
 /*copy the content of key from src to dst*/
 typedef void (*fpAssignK)(void *src, void *dst);
 /*copy the content of value from src to dst*/
 typedef void (*fpAssignV)(void *src, void *dst);
+/*give back the key/value of a node reclaimed by the hash table*/
+typedef void (*fpExpireNode)(void *key, void *value);
+/*
+ * give back the key/value of a node reclaimed by the hash table, owner is the lcore whose insert
+ * supplied them, see HashTableOps evictFunc
+ */
+typedef void (*fpEvictNode)(void *key, void *value, unsigned int owner);
+/*IPv4 address of the client of a key in host byte order, 0 if the key has none*/
+typedef uint32_t (*fpKeyIp)(void *key);
 /*update the node content when find a node in hash table*/
 typedef void (*fpUpdateV)(void *v, void *userData);
+/*initialize the value of a node inserted by hash_table_upsert*/
+typedef void (*fpInitV)(void *v, void *userData);
+/*visit a node during an iteration, a non-zero return stops the iteration*/
+typedef int (*fpVisit)(void *key, void *value, uint64_t expired, void *userData);
 
 struct UpdateCallBack
 {
@@ -53,6 +157,13 @@ struct UpdateCallBack
 	void *userData;
 };
 
+struct UpsertCallBack
+{
+	fpInitV init;
+	fpUpdateV update;
+	void *userData;
+};
+
 struct HashTableOps
 {
 	fpCompare cmp;
@@ -62,6 +173,33 @@ struct HashTableOps
 	fpAssignK assignKey;
 	fpAssignV assignValue;
 	fpAssess assessFunc;
+	fpExpireNode expireFunc;
+	/*size of the key/value struct, only used by HASH_STRATEGY_INLINE*/
+	unsigned int keySize;
+	unsigned int valueSize;
+	/*used instead of mallocFunc when provided, memory is then allocated on socket*/
+	fpMallocSocket mallocSocketFunc;
+	int socket;
+	/*HASH_TABLE_F_**/
+	unsigned int flags;
+	/*needed by hash_table_insert_key only*/
+	fpKeyHash keyHashFunc;
+	/*
+	 * Called instead of expireFunc when provided. The list strategies remember which lcore
+	 * inserted the key/value objects of a node, see hash_table_set_owner, so objects taken from
+	 * per-lcore pools can be put back into the pool they came from whichever lcore reclaims
+	 * them. A node overwritten in place keeps its objects and their owner. owner is LCORE_ID_ANY
+	 * for the other strategies.
+	 */
+	fpEvictNode evictFunc;
+	/*needed by HASH_TABLE_F_IP_INDEX only*/
+	fpKeyIp keyIpFunc;
+};
+
+/*hash value of a key, computed once by hash_table_sig and passed to the _with_sig functions*/
+struct HashSig
+{
+	unsigned int hash;
 };
 
 struct HashNodeCopy
@@ -70,6 +208,40 @@ struct HashNodeCopy
 	void *value;
 };
 
+/*counters since the table was created, summed over all lcores*/
+struct HashTableStats
+{
+	/*insert and upsert returning RET_NEW and RET_OCCUPY*/
+	uint64_t insert;
+	uint64_t occupy;
+	/*lookups finding the key, upserts returning RET_UPDATE included*/
+	uint64_t hit;
+	uint64_t miss;
+	/*inserts and resize migrations which found no slot*/
+	uint64_t failed;
+	/*slots or probe groups passed over by inserts*/
+	uint64_t collision;
+	/*live nodes overwritten by LRU or CLOCK, or given back early by hash_table_reclaim*/
+	uint64_t eviction;
+	/*expired nodes reclaimed by the sweep, hash_table_reclaim, a resize or an insert reusing their slot*/
+	uint64_t expiration;
+	uint64_t deletion;
+	/*lookups answered by HASH_TABLE_F_FILTER without probing the table, counted in miss too*/
+	uint64_t filtered;
+	/*inserts and upserts staged by HASH_TABLE_F_WRITE_COMBINE, counted in insert once flushed*/
+	uint64_t staged;
+	/*inserts refused by HASH_TABLE_F_ADMISSION rather than evicting a node, counted in failed too*/
+	uint64_t rejected;
+	/*
+	 * lookups by the number of slots (list, Robin Hood), buckets (cuckoo) or groups (inline) they examined,
+	 * probe[i] counts i+1 and the last bucket counts the longer ones too
+	 */
+	uint64_t probe[HASH_STATS_PROBE_MAX];
+	unsigned int capacity;
+	unsigned int bucketSize;
+	unsigned int totalMem;
+};
+
 /*
  * @Create hash table and init
  *
@@ -99,6 +271,13 @@ struct hashTable *hash_table_create(unsigned int capacity, enum HASH_STRATEGY mo
  *  RET_OCCUPY: Copy the content of the current node to an existed node in hash table, the current node can be release
  */
 int hash_table_insert(struct hashTable *htbl, void *data, int dLen, void *key, void *value, uint64_t timeout);
+/*
+ * @Insert node into hash table without the data it was hashed from
+ *
+ * The hash value is taken from the key by HashTableOps keyHashFunc, which is used to insert
+ * the nodes of a snapshot or of another table. Same as hash_table_insert otherwise.
+ */
+int hash_table_insert_key(struct hashTable *htbl, void *key, void *value, uint64_t timeout);
 /*
  * @search node in hash table and maybe update the node 
  *
@@ -108,10 +287,11 @@ int hash_table_insert(struct hashTable *htbl, void *data, int dLen, void *key, v
  *  dLen: data length
  *  key: calculate the hash info of data and stored in key struct which is used for searching in hash table
  *  copy: a copy of the value of the target node and the time when the node expire.
- *  callback: update the value when find the node in hash table. The operation is protected by write-lock
+ *  callback: update the value when find the node in hash table. The operation is protected by write-lock.
+ *   The list strategies check again under the write-lock that the node still holds the key
  *
  * @return
- *  NULL: not find
+ *  NULL: not find, or the node went away before callback could run
  *  Not NULL: the pointer to the node
  */
 void *hash_table_find(struct hashTable *htbl, void *data, int dLen, void *key, void *copy, struct UpdateCallBack *callback);
@@ -132,9 +312,311 @@ void *hash_table_find(struct hashTable *htbl, void *data, int dLen, void *key, v
  */
 int hash_table_update(struct hashTable *htbl, void *data, int dLen, void *key, struct UpdateCallBack *callback);
 
+/*
+ * @Insert a node or update the existing one with a single lookup
+ *
+ * The key is hashed and probed once. The probe window of the key stays locked from the lookup
+ * to the write, so concurrent upserts of the same key are serialized and only one of them
+ * inserts it. Plain inserts of the same key are not serialized with it.
+ *
+ * @param
+ *  htbl: hash table
+ *  data: the data used for calculating hash value
+ *  dLen: data length
+ *  key: calculate the hash info of data and stored in key struct, kept by a new node
+ *  value: the value struct kept by a new node
+ *  timeout: the time when a new node expire, an existing node keeps its own
+ *  callback: init is run on value before a new node is published, update on the value of the
+ *   existing node. Both run under the write-lock and may be NULL
+ *  copy: a copy of the value of the node after init or update and the time when the node expire.
+ *   It can be NULL
+ *
+ * @return
+ *  RET_FAILED: Insert failed
+ *  RET_NEW: Insert a new node
+ *  RET_OCCUPY: Copy the initialized node to an expired node in hash table, the current node can be release
+ *  RET_UPDATE: The existing node is updated, the current node can be release
+ */
+int hash_table_upsert(struct hashTable *htbl, void *data, int dLen, void *key, void *value, uint64_t timeout,
+		struct UpsertCallBack *callback, struct HashNodeCopy *copy);
+
+/*
+ * @delete node from hash table
+ *
+ * The key/value objects of the node are given back through HashTableOps expireFunc or evictFunc. The list
+ * strategies leave a tombstone in the slot so the lookups of the other keys probed past it still
+ * find them, it is freed as soon as the next slot is free or later by hash_table_expire.
+ *
+ * @param
+ *  htbl: hash table to be searched for
+ *  data: the data used for calculating hash value
+ *  dLen: data length
+ *  key: calculate the hash info of data and stored in key struct which is used for searching in hash table
+ *  copy: a copy of the value of the deleted node and the time when the node expire.
+ *
+ * @return
+ *  0: success 
+ *  -1: not find 
+ */
+int hash_table_delete(struct hashTable *htbl, void *data, int dLen, void *key, void *copy);
+
+/*
+ * @Hash data once for the _with_sig functions
+ *
+ * The data is hashed by HashTableOps hash, which fills key. The signature and the key can then be
+ * passed to any number of _with_sig calls, on this table or any table with the same hash function,
+ * and the data is not hashed again. A signature computed early lets hash_table_prefetch_sig load
+ * the slots of the key while the caller does other work.
+ *
+ * @param
+ *  htbl: hash table
+ *  data: the data used for calculating hash value
+ *  dLen: data length
+ *  key: calculate the hash info of data and stored in key struct
+ *  sig: filled with the hash value
+ *
+ * @return
+ *  0: success
+ *  -1: failed
+ */
+int hash_table_sig(struct hashTable *htbl, void *data, int dLen, void *key, struct HashSig *sig);
+void hash_table_prefetch_sig(struct hashTable *htbl, const struct HashSig *sig);
+
+/*same as the functions without _with_sig, key must have been filled by hash_table_sig*/
+void *hash_table_find_with_sig(struct hashTable *htbl, const struct HashSig *sig, void *key, void *copy, struct UpdateCallBack *callback);
+int hash_table_insert_with_sig(struct hashTable *htbl, const struct HashSig *sig, void *key, void *value, uint64_t timeout);
+int hash_table_update_with_sig(struct hashTable *htbl, const struct HashSig *sig, void *key, struct UpdateCallBack *callback);
+int hash_table_upsert_with_sig(struct hashTable *htbl, const struct HashSig *sig, void *key, void *value, uint64_t timeout,
+		struct UpsertCallBack *callback, struct HashNodeCopy *copy);
+int hash_table_delete_with_sig(struct hashTable *htbl, const struct HashSig *sig, void *key, void *copy);
+
+/*
+ * @Search a burst of nodes in hash table
+ *
+ * All the hash values are calculated first and the buckets of the whole burst are prefetched
+ * before any of them is compared, which overlaps the cache misses of the keys.
+ *
+ * @param
+ *  htbl: hash table to be searched for
+ *  data: the data used for calculating hash value of each key
+ *  dLen: data length of each key
+ *  key: the key struct of each key, filled with the hash info of its data
+ *  copy: array of num copies, the same as the copy of hash_table_find. It can be NULL
+ *  num: number of keys, at most HASH_BULK_MAX
+ *  hitMask: bit i is set when key i is found
+ *
+ * @return
+ *  -1: failed
+ *  others: the number of keys found
+ */
+int hash_table_find_bulk(struct hashTable *htbl, void **data, int *dLen, void **key, struct HashNodeCopy *copy, unsigned int num, uint64_t *hitMask);
+
+/*
+ * @Insert a burst of nodes into hash table
+ *
+ * @param
+ *  htbl: hash table to be insert
+ *  data: the data used for calculating hash value of each node
+ *  dLen: data length of each node
+ *  key: the key info of each node
+ *  value: the value struct of each node
+ *  timeout: the time when the nodes expire
+ *  num: number of nodes, at most HASH_BULK_MAX
+ *  ret: the result of each node, the same as the return value of hash_table_insert
+ *
+ * @return
+ *  -1: failed
+ *  others: the number of nodes not RET_FAILED
+ */
+int hash_table_insert_bulk(struct hashTable *htbl, void **data, int *dLen, void **key, void **value, uint64_t timeout, unsigned int num, int *ret);
+
+/*
+ * @Start an online resize of the hash table
+ *
+ * A new bucket array sized for capacity is allocated and becomes the current one. The nodes of the
+ * old array are moved by a migration cursor a few slots per insert and per hash_table_maintain call,
+ * lookups consult both arrays until the migration is done. Only HASH_STRATEGY_SELF_EXPIRED,
+ * HASH_STRATEGY_LRU and HASH_STRATEGY_CLOCK support resizing.
+ *
+ * @param
+ *  htbl: hash table to be resized
+ *  capacity: the new maximum count number of the hash table, it can be smaller than the current one
+ *
+ * @return
+ *  0: success
+ *  -1: failed, unsupported mode or a migration is still in progress
+ */
+int hash_table_resize(struct hashTable *htbl, unsigned int capacity);
+
+/*
+ * @Let hash_table_maintain grow the table when inserts fail or it gets full and shrink it when it gets empty
+ *
+ * @param
+ *  htbl: hash table
+ *  minCapacity: the capacity never shrinks below it, 0 means the capacity the table was created with
+ *  maxCapacity: the capacity never grows above it, 0 disables automatic resizing
+ *
+ * @return
+ *  0: success
+ *  -1: failed
+ */
+int hash_table_set_resize(struct hashTable *htbl, unsigned int minCapacity, unsigned int maxCapacity);
+
+/*
+ * @Bound the distance between a node of HASH_STRATEGY_ROBINHOOD and its home slot
+ *
+ * Lower values bound the cost of a lookup miss, higher ones let the table fill up more before
+ * inserts fail. Nodes already farther than a lowered bound are still found.
+ *
+ * @param
+ *  htbl: hash table
+ *  maxDisplacement: maximum number of slots between a node and its home slot
+ *
+ * @return
+ *  0: success
+ *  -1: failed, unsupported mode or out of range
+ */
+int hash_table_set_max_displacement(struct hashTable *htbl, unsigned int maxDisplacement);
+
+/*
+ * @Reclaim expired nodes
+ *
+ * The slots are grouped in segments remembering their earliest expiry time. Segments are visited
+ * from a cursor shared by all callers and skipped while nothing in them can have expired, so it can
+ * be called from every lcore each maintenance tick with a small budget. expireFunc (evictFunc) is called with
+ * the key/value of each reclaimed node; for HASH_STRATEGY_INLINE they point into the slot and are
+ * only valid during the call. HASH_STRATEGY_LRU nodes never expire, the sweep only frees the
+ * tombstones left by hash_table_delete.
+ *
+ * @param
+ *  htbl: hash table
+ *  budget: about the maximum number of slots examined
+ *
+ * @return
+ *  the number of nodes reclaimed
+ */
+int hash_table_expire(struct hashTable *htbl, unsigned int budget);
+
+/*
+ * @Give back the objects of an owner when its memory runs low
+ *
+ * The list strategies walk their slots from a cursor shared by all callers, a window of 32 slots
+ * at a time. The expired nodes met are reclaimed whoever owns them. While fewer than want nodes
+ * of owner were given back, the oldest live node of owner in each window is evicted as well: the
+ * node expiring first, the least recently used one for HASH_STRATEGY_LRU and for
+ * HASH_STRATEGY_CLOCK one not referenced since the previous pass. The objects go back through
+ * HashTableOps evictFunc (expireFunc). The other strategies hold no objects of an owner and
+ * reclaim nothing.
+ *
+ * @param
+ *  htbl: hash table
+ *  owner: lcore whose objects are wanted, LCORE_ID_ANY for the nodes of any owner
+ *  want: number of nodes of owner after which it stops
+ *  budget: about the maximum number of slots examined
+ *
+ * @return
+ *  the number of nodes of owner given back
+ */
+int hash_table_reclaim(struct hashTable *htbl, unsigned int owner, unsigned int want, unsigned int budget);
+
+/*
+ * @Delete the nodes of a client address or of a subnet
+ *
+ * Only the chains of the /24 subnets covered by the prefix are walked, so a single address or a
+ * /24 costs about its own nodes and a shorter prefix adds one chain per /24 it covers. The nodes
+ * are given back through HashTableOps evictFunc (expireFunc) and counted as deletions. Nodes
+ * still staged by HASH_TABLE_F_WRITE_COMBINE are not seen.
+ *
+ * @param
+ *  htbl: hash table created with HASH_TABLE_F_IP_INDEX
+ *  ip: IPv4 address in host byte order, the bits past prefixLen are ignored
+ *  prefixLen: 32 for a single address, 0 to 31 for a subnet
+ *
+ * @return
+ *  the number of nodes deleted, -1 if the table has no index or prefixLen is out of range
+ */
+int hash_table_invalidate_by_ip(struct hashTable *htbl, uint32_t ip, unsigned int prefixLen);
+
+/*
+ * @Periodic maintenance of the hash table, moves the migration cursor of a resize, runs the resize policy,
+ * rebuilds the filter of HASH_TABLE_F_FILTER, ages the sketch of HASH_TABLE_F_ADMISSION and flushes the old
+ * nodes staged by HASH_TABLE_F_WRITE_COMBINE
+ *
+ * Every lcore accessing the table must call it regularly from its main loop, outside of any other
+ * hash_table_* call. The bucket array left by a resize is released only after each lcore that has
+ * accessed the table went through it again.
+ *
+ * @param
+ *  htbl: hash table
+ *
+ * @return
+ */
+void hash_table_maintain(struct hashTable *htbl);
+
+/*
+ * @Write the nodes staged by the calling lcore to the table, see HASH_TABLE_F_WRITE_COMBINE
+ *
+ * Call it before the lcore stops using the table or when another lcore must see its inserts at once.
+ */
+void hash_table_flush(struct hashTable *htbl);
+
+/*
+ * @Number of slots the iteration ranges are taken from
+ */
+unsigned int hash_table_slots(struct hashTable *htbl);
+
+/*
+ * @Visit the live nodes of a range of slots
+ *
+ * Split [0, hash_table_slots()) into disjoint ranges to scan the table from several lcores or
+ * threads at once. Each node is visited under the read lock of its slot, so the visitor sees
+ * a consistent node but must not call back into the table. Expired nodes are skipped. During a
+ * resize only the nodes already migrated to the new array are visited.
+ *
+ * @param
+ *  htbl: hash table
+ *  start: first slot of the range
+ *  end: slot after the range
+ *  visit: called for each node, stops the iteration by returning non-zero
+ *  userData: passed to visit
+ *  next: optional, set to the slot to resume from, end when the range is done
+ *
+ * @return
+ *  the number of nodes visited, -1 on failure
+ */
+int hash_table_iterate(struct hashTable *htbl, unsigned int start, unsigned int end, fpVisit visit, void *userData, unsigned int *next);
+
+/*
+ * @Read the counters of the hash table
+ *
+ * Each lcore counts in its own cache line, so the hot path never writes a shared line and
+ * reading only sums RTE_MAX_LCORE lines. It is cheap enough to be polled every second, unlike
+ * hash_table_assess which scans the whole table.
+ *
+ * @param
+ *  htbl: hash table
+ *  stats: filled with the counters
+ *
+ * @return
+ *  0: success 
+ *  -1: failed 
+ */
+int hash_table_stats(struct hashTable *htbl, struct HashTableStats *stats);
+
 void hash_table_destroy(struct hashTable *htbl);
 void hash_table_assess(struct hashTable *htbl);
 
+/*
+ * @Set the owner recorded for the nodes inserted by the calling thread, see HashTableOps evictFunc
+ *
+ * Nodes are owned by the inserting lcore by default. A thread filling the tables with objects of
+ * another lcore, such as a restore at startup, names that lcore instead.
+ *
+ * @param
+ *  lcore: owner of the objects inserted from now on, LCORE_ID_ANY restores the calling lcore
+ */
+void hash_table_set_owner(unsigned int lcore);
+
 #ifdef __cplusplus
 }
 #endif
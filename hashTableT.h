@@ -0,0 +1,411 @@
+/*
+ *
+ *  Header-only C++ hash table for fixed size keys and values.
+ *
+ *  Key type, value type, hasher and expiry policy are template parameters, so the compare, the
+ *  copies and the probe are inlined instead of going through HashTableOps and gHashInf. Keys are
+ *  compared byte for byte over sizeof(K), a single integer compare for keys of 4 or 8 bytes and a
+ *  memcmp otherwise, such as for the 16-byte struct key. Every field of the key is compared, there
+ *  is no cmp callback to skip some. Both key and value are copied into the slot with fixed size
+ *  moves, as with HASH_STRATEGY_INLINE.
+ *
+ *  Slots are probed linearly from the home slot up to HASH_T_PROBE slots, a lookup stops at the
+ *  first free slot. A deleted or expired node leaves a tombstone which is freed once the slot
+ *  behind it is free.
+ *
+ *  The table takes no lock. It is meant to be owned by one lcore, as a sub-table created with
+ *  HASH_TABLE_F_SINGLE_OWNER is.
+ *
+ */
+
+#ifndef _HASHTABLET_H_
+#define _HASHTABLET_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_prefetch.h>
+
+#include "hashTable.h"
+
+/*slots examined from the home slot of a key*/
+#define HASH_T_PROBE 8
+/*slots per node of capacity*/
+#define HASH_T_LOAD_FACTOR 2
+
+/*compare the bytes of two keys, sizes of a machine word are one compare*/
+template <size_t N>
+struct HashBytes
+{
+	static bool Equal(const void *a, const void *b)
+	{
+		return memcmp(a, b, N) == 0;
+	}
+};
+
+template <>
+struct HashBytes<8>
+{
+	static bool Equal(const void *a, const void *b)
+	{
+		uint64_t x, y;
+
+		memcpy(&x, a, sizeof(x));
+		memcpy(&y, b, sizeof(y));
+		return x == y;
+	}
+};
+
+template <>
+struct HashBytes<4>
+{
+	static bool Equal(const void *a, const void *b)
+	{
+		uint32_t x, y;
+
+		memcpy(&x, a, sizeof(x));
+		memcpy(&y, b, sizeof(y));
+		return x == y;
+	}
+};
+
+/*nodes expire at their timeout, insert fails when the probe window has no free or expired slot*/
+struct HashPolicySelfExpired
+{
+	enum { EVICT = 0 };
+
+	static bool Live(uint64_t timeout, uint64_t now)
+	{
+		return now < timeout;
+	}
+
+	static void Touch(__rte_unused uint64_t &timeout, __rte_unused uint64_t now)
+	{
+	}
+};
+
+/*timeout is the last access time, insert evicts the oldest node of a full probe window*/
+struct HashPolicyLru
+{
+	enum { EVICT = 1 };
+
+	static bool Live(__rte_unused uint64_t timeout, __rte_unused uint64_t now)
+	{
+		return true;
+	}
+
+	static void Touch(uint64_t &timeout, uint64_t now)
+	{
+		timeout = now;
+	}
+};
+
+/*
+ * K and V are plain data copied with memcpy. Hasher provides
+ *  static unsigned int Hash(const K &key);
+ * Policy is HashPolicySelfExpired or HashPolicyLru.
+ */
+template <typename K, typename V, typename Hasher, typename Policy = HashPolicySelfExpired>
+class HashTableT
+{
+public:
+	HashTableT() : m_slot(NULL), m_mask(0), m_capacity(0), m_cursor(0)
+	{
+	}
+
+	~HashTableT()
+	{
+		free(m_slot);
+	}
+
+	/*
+	 * @return
+	 *  0: success
+	 *  -1: failed
+	 */
+	int Init(unsigned int capacity)
+	{
+		unsigned int count = 1;
+
+		if( m_slot || !capacity )
+		{
+			return -1;
+		}
+		while( count < (uint64_t)capacity*HASH_T_LOAD_FACTOR )
+		{
+			count <<= 1;
+		}
+		m_slot = (Slot*)calloc(count, sizeof(Slot));
+		if( !m_slot )
+		{
+			return -1;
+		}
+		m_mask = count - 1;
+		m_capacity = capacity;
+
+		return 0;
+	}
+
+	void Prefetch(const K &key) const
+	{
+		rte_prefetch0(&m_slot[Hasher::Hash(key) & m_mask]);
+	}
+
+	/*
+	 * @param
+	 *  copy: filled with the value of the node, it can be NULL
+	 *  expired: filled with the time when the node expire, it can be NULL
+	 *
+	 * @return
+	 *  the value of the node, NULL if not find. It is only valid until the next insert or delete
+	 */
+	V *Find(const K &key, V *copy = NULL, uint64_t *expired = NULL)
+	{
+		uint64_t now = rte_rdtsc();
+		Slot *s = Search(key, now);
+
+		if( !s )
+		{
+			return NULL;
+		}
+		Policy::Touch(s->timeout, now);
+		if( copy )
+		{
+			*copy = s->value;
+		}
+		if( expired )
+		{
+			*expired = s->timeout;
+		}
+		return &s->value;
+	}
+
+	/*
+	 * @return
+	 *  RET_FAILED: Insert failed
+	 *  RET_NEW: Insert a new node
+	 *  RET_OCCUPY: the node of the key, an expired or an evicted node is overwritten
+	 */
+	int Insert(const K &key, const V &value, uint64_t timeout)
+	{
+		uint64_t now = rte_rdtsc();
+		int ret = RET_FAILED;
+		Slot *s = Claim(key, now, &ret);
+
+		if( s )
+		{
+			s->key = key;
+			s->value = value;
+			s->timeout = timeout;
+			s->status = SLOT_USE;
+		}
+		return ret;
+	}
+
+	/*
+	 * @Insert a node or update the existing one with a single probe
+	 *
+	 * fn provides void Init(V &value) run on a new node and void Update(V &value) run on the
+	 * existing node, see hash_table_upsert.
+	 *
+	 * @return
+	 *  RET_FAILED, RET_NEW, RET_OCCUPY or RET_UPDATE
+	 */
+	template <typename Fn>
+	int Upsert(const K &key, uint64_t timeout, Fn &fn)
+	{
+		uint64_t now = rte_rdtsc();
+		int ret = RET_FAILED;
+		Slot *s = Claim(key, now, &ret);
+
+		if( !s )
+		{
+			return ret;
+		}
+		if( s->status == SLOT_USE && HashBytes<sizeof(K)>::Equal(&s->key, &key) && Policy::Live(s->timeout, now) )
+		{
+			Policy::Touch(s->timeout, now);
+			fn.Update(s->value);
+			return RET_UPDATE;
+		}
+		s->key = key;
+		fn.Init(s->value);
+		s->timeout = timeout;
+		s->status = SLOT_USE;
+		return ret;
+	}
+
+	/*
+	 * @return
+	 *  0: success
+	 *  -1: not find
+	 */
+	int Delete(const K &key, V *copy = NULL)
+	{
+		Slot *s = Search(key, rte_rdtsc());
+
+		if( !s )
+		{
+			return RET_FAILED;
+		}
+		if( copy )
+		{
+			*copy = s->value;
+		}
+		Bury(s - m_slot);
+		return 0;
+	}
+
+	/*
+	 * @Reclaim the expired nodes of the next budget slots
+	 *
+	 * @return
+	 *  the number of nodes reclaimed
+	 */
+	int Expire(unsigned int budget)
+	{
+		uint64_t now = rte_rdtsc();
+		unsigned int idx = 0;
+		int reclaimed = 0;
+
+		for( ; budget > 0; budget--)
+		{
+			/*backwards, so the tombstones of a chain are freed from its end*/
+			idx = (m_cursor--) & m_mask;
+			if( m_slot[idx].status == SLOT_USE && !Policy::Live(m_slot[idx].timeout, now) )
+			{
+				Bury(idx);
+				reclaimed++;
+			}
+			else if( m_slot[idx].status == SLOT_DELETED )
+			{
+				Bury(idx);
+			}
+		}
+		return reclaimed;
+	}
+
+	unsigned int Slots() const
+	{
+		return m_mask + 1;
+	}
+
+	unsigned int Capacity() const
+	{
+		return m_capacity;
+	}
+
+private:
+	enum
+	{
+		SLOT_AVAILABLE = 0,
+		SLOT_USE,
+		SLOT_DELETED
+	};
+
+	struct Slot
+	{
+		uint64_t timeout;
+		K key;
+		V value;
+		uint8_t status;
+	};
+
+	/*not copyable, the slots are owned by the table*/
+	HashTableT(const HashTableT &);
+	HashTableT &operator=(const HashTableT &);
+
+	Slot *Search(const K &key, uint64_t now)
+	{
+		unsigned int idx = Hasher::Hash(key);
+		unsigned int count = 0;
+		Slot *s = NULL;
+
+		for( ; count < HASH_T_PROBE; count++, idx++)
+		{
+			s = &m_slot[idx & m_mask];
+			if( s->status == SLOT_AVAILABLE )
+			{
+				break;
+			}
+			if( s->status == SLOT_USE && HashBytes<sizeof(K)>::Equal(&s->key, &key) )
+			{
+				return Policy::Live(s->timeout, now) ? s : NULL;
+			}
+		}
+		return NULL;
+	}
+
+	/*
+	 * The slot an insert of key writes to: the node of the key, else the first tombstone, expired
+	 * node or free slot of the window, else the oldest node when the policy evicts.
+	 */
+	Slot *Claim(const K &key, uint64_t now, int *ret)
+	{
+		unsigned int idx = Hasher::Hash(key);
+		unsigned int count = 0;
+		Slot *reuse = NULL;
+		Slot *victim = NULL;
+		Slot *s = NULL;
+
+		for( ; count < HASH_T_PROBE; count++, idx++)
+		{
+			s = &m_slot[idx & m_mask];
+			if( s->status == SLOT_AVAILABLE )
+			{
+				reuse = reuse ? reuse : s;
+				break;
+			}
+			if( s->status == SLOT_USE && HashBytes<sizeof(K)>::Equal(&s->key, &key) )
+			{
+				*ret = RET_OCCUPY;
+				return s;
+			}
+			if( !reuse && (s->status == SLOT_DELETED || !Policy::Live(s->timeout, now)) )
+			{
+				reuse = s;
+			}
+			else if( Policy::EVICT && s->status == SLOT_USE && (!victim || s->timeout < victim->timeout) )
+			{
+				victim = s;
+			}
+		}
+
+		if( reuse )
+		{
+			*ret = (reuse->status == SLOT_USE) ? RET_OCCUPY : RET_NEW;
+			return reuse;
+		}
+		if( victim )
+		{
+			*ret = RET_OCCUPY;
+		}
+		return victim;
+	}
+
+	/*a node is freed when the slot behind it is, otherwise it leaves a tombstone for the lookups passing it*/
+	void Bury(unsigned int idx)
+	{
+		unsigned int count = 0;
+
+		m_slot[idx].status = SLOT_DELETED;
+		for( ; count < HASH_T_PROBE && m_slot[idx & m_mask].status == SLOT_DELETED; count++, idx--)
+		{
+			if( m_slot[(idx+1) & m_mask].status != SLOT_AVAILABLE )
+			{
+				break;
+			}
+			m_slot[idx & m_mask].status = SLOT_AVAILABLE;
+		}
+	}
+
+	Slot *m_slot;
+	unsigned int m_mask;
+	unsigned int m_capacity;
+	unsigned int m_cursor;
+};
+
+#endif
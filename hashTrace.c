@@ -0,0 +1,366 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rte_config.h>
+#include <rte_atomic.h>
+#include <rte_cycles.h>
+#include <rte_common.h>
+#include <rte_lcore.h>
+#include <rte_memory.h>
+
+#include "hashTrace.h"
+
+#define TRACE_MAGIC 0x43525448
+#define TRACE_VERSION 1
+#define TRACE_PATH_MAX 256
+
+#define TRACE_NONE -1
+
+struct HashTraceHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t recordSize;
+	uint32_t count;
+	uint64_t hz;
+	/*records of all the streams*/
+	uint64_t total;
+};
+
+/*followed by count records of the lcore*/
+struct HashTraceStreamHeader
+{
+	uint32_t lcore;
+	uint32_t count;
+};
+
+struct HashTraceRing
+{
+	/*records written so far, only moved by the lcore of the ring*/
+	volatile uint64_t head;
+	/*head when capture was started*/
+	volatile uint64_t base;
+	unsigned int lcore;
+} __rte_cache_aligned;
+
+struct hashTrace
+{
+	volatile int running;
+	unsigned int count;
+	uint64_t mask;
+	uint64_t hz;
+	size_t size;
+	fpFree freeFunc;
+	int lcoreRing[RTE_MAX_LCORE];
+	/*followed by the records of each ring*/
+	struct HashTraceRing ring[0];
+};
+
+static inline struct HashTraceRecord *TraceRecords(struct hashTrace *tr, unsigned int idx)
+{
+	return (struct HashTraceRecord*)(tr->ring + tr->count) + (size_t)idx*(tr->mask+1);
+}
+
+struct hashTrace *hash_trace_create(const unsigned int *lcores, unsigned int count, unsigned int records,
+		fpMalloc mallocFunc, fpFree freeFunc)
+{
+	struct hashTrace *tr = NULL;
+	size_t size = 0;
+	uint64_t ringSize = 0;
+	unsigned int i = 0;
+
+	if( !lcores || !count || !records || !mallocFunc || !freeFunc )
+	{
+		printf("The traced lcores and the malloc/free functions must be provided!\n");
+		return NULL;
+	}
+
+	ringSize = rte_align32pow2(records);
+	if( !ringSize )
+	{
+		printf("Too many trace records per lcore!\n");
+		return NULL;
+	}
+	size = sizeof(struct hashTrace) + sizeof(struct HashTraceRing)*count + sizeof(struct HashTraceRecord)*ringSize*count;
+	tr = mallocFunc(size);
+	if( !tr )
+	{
+		printf("Malloc Hash Trace failed\n");
+		return NULL;
+	}
+	/*the records are left alone, only the ones below head are ever read*/
+	memset(tr, 0x00, sizeof(struct hashTrace) + sizeof(struct HashTraceRing)*count);
+	tr->count = count;
+	tr->mask = ringSize - 1;
+	tr->hz = rte_get_tsc_hz();
+	tr->size = size;
+	tr->freeFunc = freeFunc;
+	for( i = 0; i < RTE_MAX_LCORE; i++)
+	{
+		tr->lcoreRing[i] = TRACE_NONE;
+	}
+	for( i = 0; i < count; i++)
+	{
+		tr->ring[i].lcore = lcores[i];
+		if( lcores[i] < RTE_MAX_LCORE )
+		{
+			tr->lcoreRing[lcores[i]] = i;
+		}
+	}
+
+	return tr;
+}
+
+void hash_trace_destroy(struct hashTrace *tr)
+{
+	if( tr )
+	{
+		tr->freeFunc(tr, tr->size);
+	}
+}
+
+void hash_trace_start(struct hashTrace *tr)
+{
+	unsigned int i = 0;
+
+	if( !tr )
+	{
+		return;
+	}
+	for( ; i < tr->count; i++)
+	{
+		tr->ring[i].base = tr->ring[i].head;
+	}
+	rte_smp_wmb();
+	tr->running = 1;
+}
+
+void hash_trace_stop(struct hashTrace *tr)
+{
+	if( tr )
+	{
+		tr->running = 0;
+	}
+}
+
+void hash_trace_record(struct hashTrace *tr, unsigned int op, const struct HashSig *sig, uint32_t fingerprint,
+		uint64_t timeout, int result)
+{
+	struct HashTraceRing *ring = NULL;
+	struct HashTraceRecord *rec = NULL;
+	unsigned int lcore = 0;
+	uint64_t now = 0;
+	int idx = TRACE_NONE;
+
+	if( !tr || !tr->running )
+	{
+		return;
+	}
+	lcore = rte_lcore_id();
+	if( lcore < RTE_MAX_LCORE )
+	{
+		idx = tr->lcoreRing[lcore];
+	}
+	if( idx == TRACE_NONE )
+	{
+		return;
+	}
+
+	ring = &tr->ring[idx];
+	rec = TraceRecords(tr, idx) + (ring->head & tr->mask);
+	now = rte_rdtsc();
+	rec->tsc = now;
+	rec->ttl = timeout > now ? timeout - now : 0;
+	rec->hash = sig->hash;
+	rec->fingerprint = fingerprint;
+	rec->op = op;
+	rec->result = result;
+	rec->pad = 0;
+	rec->reserved = 0;
+	rte_smp_wmb();
+	ring->head++;
+}
+
+/*write the records of the ring from start to head, wrapping around the end of the ring*/
+static int TraceWriteRing(struct hashTrace *tr, unsigned int idx, uint64_t start, uint64_t head, FILE *fp)
+{
+	struct HashTraceRecord *rec = TraceRecords(tr, idx);
+	uint64_t from = start & tr->mask;
+	uint64_t n = head - start;
+	uint64_t first = RTE_MIN(n, tr->mask + 1 - from);
+
+	if( fwrite(rec + from, sizeof(struct HashTraceRecord), first, fp) != first )
+	{
+		return -1;
+	}
+	if( n > first && fwrite(rec, sizeof(struct HashTraceRecord), n - first, fp) != n - first )
+	{
+		return -1;
+	}
+	return 0;
+}
+
+int64_t hash_trace_dump(struct hashTrace *tr, const char *path)
+{
+	char tmp[TRACE_PATH_MAX] = {0};
+	struct HashTraceHeader hdr;
+	struct HashTraceStreamHeader shdr;
+	FILE *fp = NULL;
+	uint64_t head = 0;
+	uint64_t start = 0;
+	unsigned int i = 0;
+
+	if( !tr || !path || strlen(path) + sizeof(".tmp") > TRACE_PATH_MAX )
+	{
+		printf("Invalid trace or trace path!\n");
+		return -1;
+	}
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	fp = fopen(tmp, "wb");
+	if( !fp )
+	{
+		printf("Open trace %s failed.\n", tmp);
+		return -1;
+	}
+
+	memset(&hdr, 0x00, sizeof(hdr));
+	hdr.magic = TRACE_MAGIC;
+	hdr.version = TRACE_VERSION;
+	hdr.recordSize = sizeof(struct HashTraceRecord);
+	hdr.count = tr->count;
+	hdr.hz = tr->hz;
+	/*the header is written again with the total once the streams are*/
+	if( fwrite(&hdr, sizeof(hdr), 1, fp) != 1 )
+	{
+		goto FAILED;
+	}
+
+	for( ; i < tr->count; i++)
+	{
+		head = tr->ring[i].head;
+		rte_smp_rmb();
+		start = tr->ring[i].base;
+		/*the older records were overwritten*/
+		if( head - start > tr->mask + 1 )
+		{
+			start = head - (tr->mask + 1);
+		}
+		shdr.lcore = tr->ring[i].lcore;
+		shdr.count = head - start;
+		if( fwrite(&shdr, sizeof(shdr), 1, fp) != 1 || TraceWriteRing(tr, i, start, head, fp) < 0 )
+		{
+			goto FAILED;
+		}
+		hdr.total += shdr.count;
+	}
+
+	if( fseek(fp, 0, SEEK_SET) < 0 || fwrite(&hdr, sizeof(hdr), 1, fp) != 1 )
+	{
+		goto FAILED;
+	}
+	if( fclose(fp) != 0 )
+	{
+		fp = NULL;
+		goto FAILED;
+	}
+	fp = NULL;
+	if( rename(tmp, path) < 0 )
+	{
+		printf("Rename trace %s failed.\n", tmp);
+		goto FAILED;
+	}
+
+	return hdr.total;
+
+FAILED:
+	printf("Write trace %s failed.\n", tmp);
+	if( fp )
+	{
+		fclose(fp);
+	}
+	unlink(tmp);
+	return -1;
+}
+
+struct HashTraceFile *hash_trace_load(const char *path)
+{
+	struct HashTraceHeader hdr;
+	struct HashTraceStreamHeader shdr;
+	struct HashTraceFile *file = NULL;
+	struct HashTraceStream *stream = NULL;
+	FILE *fp = NULL;
+	unsigned int i = 0;
+
+	if( !path || !(fp = fopen(path, "rb")) )
+	{
+		printf("Open trace %s failed.\n", path ? path : "");
+		return NULL;
+	}
+	if( fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.magic != TRACE_MAGIC || hdr.version != TRACE_VERSION
+			|| hdr.recordSize != sizeof(struct HashTraceRecord) || !hdr.count || hdr.count > RTE_MAX_LCORE || !hdr.hz )
+	{
+		printf("Invalid trace header in %s.\n", path);
+		goto FAILED;
+	}
+
+	file = malloc(sizeof(struct HashTraceFile) + sizeof(struct HashTraceStream)*hdr.count);
+	if( !file )
+	{
+		printf("Malloc trace file failed.\n");
+		goto FAILED;
+	}
+	memset(file, 0x00, sizeof(struct HashTraceFile) + sizeof(struct HashTraceStream)*hdr.count);
+	file->hz = hdr.hz;
+
+	for( ; i < hdr.count; i++)
+	{
+		if( fread(&shdr, sizeof(shdr), 1, fp) != 1 )
+		{
+			printf("Truncated trace %s.\n", path);
+			goto FAILED;
+		}
+		stream = &file->stream[file->count++];
+		stream->lcore = shdr.lcore;
+		stream->count = shdr.count;
+		if( !shdr.count )
+		{
+			continue;
+		}
+		stream->rec = malloc(sizeof(struct HashTraceRecord)*shdr.count);
+		if( !stream->rec )
+		{
+			printf("Malloc trace records failed.\n");
+			goto FAILED;
+		}
+		if( fread(stream->rec, sizeof(struct HashTraceRecord), shdr.count, fp) != shdr.count )
+		{
+			printf("Truncated trace %s.\n", path);
+			goto FAILED;
+		}
+	}
+
+	fclose(fp);
+	return file;
+
+FAILED:
+	hash_trace_unload(file);
+	fclose(fp);
+	return NULL;
+}
+
+void hash_trace_unload(struct HashTraceFile *file)
+{
+	unsigned int i = 0;
+
+	if( !file )
+	{
+		return;
+	}
+	for( ; i < file->count; i++)
+	{
+		free(file->stream[i].rec);
+	}
+	free(file);
+}
@@ -0,0 +1,140 @@
+/*
+ *
+ *  Capture of the operations of a hash table for offline replay.
+ *
+ *  Each traced lcore appends fixed size records to a ring of its own, no lock nor atomic is taken
+ *  and the ring keeps the last records of the lcore. A record holds the operation, the hash and a
+ *  second fingerprint of the key, the TSC it was made at, the time to live given to an insert and
+ *  the result the table answered. Neither the key nor the value is recorded.
+ *
+ *  The rings are allocated by the mallocFunc given to hash_trace_create, memory shared between
+ *  processes lets another process dump them. hash_trace_dump writes the records of each lcore to a
+ *  file, oldest first. hash_trace_load reads the file back as one stream per lcore, to be replayed
+ *  against a table of any strategy and configuration, see test_mempool.
+ *
+ */
+
+#ifndef _HASHTRACE_H_
+#define _HASHTRACE_H_
+
+#include <stdint.h>
+
+#include "hashTable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum HASH_TRACE_OP
+{
+	/*result: 1 found, 0 not found*/
+	HASH_TRACE_FIND = 1,
+	/*result: the return value of hash_table_insert*/
+	HASH_TRACE_INSERT,
+	/*result: the return value of hash_table_upsert*/
+	HASH_TRACE_UPSERT,
+	/*result: the return value of hash_table_delete*/
+	HASH_TRACE_DELETE,
+	HASH_TRACE_OP_MAX
+};
+
+struct HashTraceRecord
+{
+	/*TSC of the traced process when the operation returned*/
+	uint64_t tsc;
+	/*cycles from tsc to the timeout given to an insert or upsert, 0 for the other operations*/
+	uint64_t ttl;
+	/*hash value of the key, see HashSig*/
+	uint32_t hash;
+	/*a second hash of the key telling apart the keys of the same hash value*/
+	uint32_t fingerprint;
+	uint8_t op;
+	int8_t result;
+	uint16_t pad;
+	uint32_t reserved;
+};
+
+struct hashTrace;
+
+/*
+ * @Create the rings of the traced lcores, capture is stopped
+ *
+ * @param
+ *  lcores: lcores whose operations are recorded
+ *  count: number of lcores
+ *  records: number of records of each ring, rounded up to a power of two
+ *  mallocFunc/freeFunc: allocate the rings, one block of memory. Pages of the rings are only
+ *   written once capture runs
+ *
+ * @return
+ *  The trace, NULL if failed
+ */
+struct hashTrace *hash_trace_create(const unsigned int *lcores, unsigned int count, unsigned int records,
+		fpMalloc mallocFunc, fpFree freeFunc);
+void hash_trace_destroy(struct hashTrace *tr);
+
+/*
+ * @Start or stop capture
+ *
+ * Start forgets the records of a previous capture. Stop before dumping, a record written while
+ * the ring is dumped may be torn.
+ */
+void hash_trace_start(struct hashTrace *tr);
+void hash_trace_stop(struct hashTrace *tr);
+
+/*
+ * @Record an operation of the calling lcore
+ *
+ * Returns at once when capture is stopped or the lcore is not traced.
+ *
+ * @param
+ *  tr: trace, may be NULL
+ *  op: HASH_TRACE_OP
+ *  sig: hash value of the key
+ *  fingerprint: second hash of the key
+ *  timeout: the time when the node inserted expire, 0 for lookups and deletes
+ *  result: see HASH_TRACE_OP
+ */
+void hash_trace_record(struct hashTrace *tr, unsigned int op, const struct HashSig *sig, uint32_t fingerprint,
+		uint64_t timeout, int result);
+
+/*
+ * @Write the records of the current or last capture to a file
+ *
+ * The file is written under path.tmp and renamed when complete.
+ *
+ * @return
+ *  the number of records written, -1 if failed
+ */
+int64_t hash_trace_dump(struct hashTrace *tr, const char *path);
+
+/*records of one traced lcore, oldest first*/
+struct HashTraceStream
+{
+	unsigned int lcore;
+	unsigned int count;
+	struct HashTraceRecord *rec;
+};
+
+struct HashTraceFile
+{
+	/*TSC frequency of the traced process*/
+	uint64_t hz;
+	unsigned int count;
+	struct HashTraceStream stream[0];
+};
+
+/*
+ * @Read a file written by hash_trace_dump
+ *
+ * @return
+ *  The streams of the file, NULL if failed
+ */
+struct HashTraceFile *hash_trace_load(const char *path);
+void hash_trace_unload(struct HashTraceFile *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
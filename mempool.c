@@ -39,6 +39,16 @@ struct Mempool
 	unsigned int objectSize;
 	unsigned int log2xSize;
 
+	/*objects put back by other threads, linked through their first word*/
+	void *volatile remote;
+
+	/*objects handed out and not put back yet, and the low watermark callback*/
+	unsigned int usedCount;
+	unsigned int lowWatermark;
+	lowWatermarkFunc lowFunc;
+	void *lowData;
+	int lowRunning;
+
 	struct MempoolOps ops;
 };
 
@@ -140,6 +150,17 @@ static void *mempool_get_object_internal(struct Mempool *mp)
 		block = block->next;
 	}
 
+	if( !block && mempool_reclaim_remote(mp) > 0 )
+	{
+		prev = NULL;
+		block = mp->block;
+		while( block && (block->free <= 0) )
+		{
+			prev = block;
+			block = block->next;
+		}
+	}
+
 	if( !block )
 	{
 		ret = mp->ops.createMemblock(mp, mp->objectSize, mp->expandElementCount);
@@ -158,6 +179,7 @@ static void *mempool_get_object_internal(struct Mempool *mp)
 	obj = block->data + (block->firstFree << mp->log2xSize);
 	block->firstFree = *(unsigned int*)obj;
 	block->free--;
+	mp->usedCount++;
 	if( block->free > 0 && (block != mp->block) )
 	{
 		prev->next = block->next;
@@ -201,6 +223,7 @@ static int mempool_put_object_internal(struct Mempool *mp, void *obj)
 	idx = ((unsigned char*)obj - block->data)>>mp->log2xSize;
 	block->firstFree = idx;
 	block->free++;
+	mp->usedCount--;
 
 	return 0;
 }
@@ -213,7 +236,7 @@ static int mempool_create_memblock(struct Mempool *mp, unsigned int objSize, uns
 	void *addr = NULL;
 	unsigned int i = 0;
 
-	if( mp->currentElementCount + elementCount > mp->maxElementCount )
+	if( !elementCount || mp->currentElementCount + elementCount > mp->maxElementCount )
 	{
 		printf("Can't create memblock. Exceed the maximum element count:%d\n", mp->maxElementCount);
 		return -1;
@@ -226,7 +249,7 @@ static int mempool_create_memblock(struct Mempool *mp, unsigned int objSize, uns
 		return -1;
 	}
 	block = (struct BlockHeader*)addr;
-	block->free = mp->initElementCount;
+	block->free = elementCount;
 	block->firstFree = 0;
 	block->elementCount = elementCount;
 	block->dataSize = elementCount*objSize;
@@ -333,6 +356,27 @@ FAILED:
 	return NULL;
 }
 
+static inline int mempool_low(struct Mempool *mp)
+{
+	return mp->maxElementCount - mp->usedCount <= mp->lowWatermark;
+}
+
+static void mempool_run_low_watermark(struct Mempool *mp)
+{
+	if( mp->lowRunning )
+	{
+		return;
+	}
+	if( mempool_reclaim_remote(mp) > 0 && !mempool_low(mp) )
+	{
+		return;
+	}
+
+	mp->lowRunning = 1;
+	mp->lowFunc(mp, mp->lowData);
+	mp->lowRunning = 0;
+}
+
 void *mempool_get_object(struct Mempool *mp)
 {
 	if( !mp )
@@ -340,6 +384,10 @@ void *mempool_get_object(struct Mempool *mp)
 		return NULL;
 	}
 
+	if( mp->lowFunc && mempool_low(mp) )
+	{
+		mempool_run_low_watermark(mp);
+	}
 	return mp->ops.getObject(mp);
 }
 
@@ -361,6 +409,66 @@ int mempool_put_object(struct Mempool *mp, void *obj)
 #endif
 }
 
+int mempool_put_object_remote(struct Mempool *mp, void *obj)
+{
+	void *head = NULL;
+
+#ifdef MEMPOOL_HEADER
+	if( mp && obj )
+	{
+		mp = ((struct ObjectHeader*)((unsigned char*)obj-mp->headerSize))->pool;
+	}
+#endif
+	if( !mp || !obj )
+	{
+		return -1;
+	}
+
+	do
+	{
+		head = mp->remote;
+		*(void**)obj = head;
+	} while( !__sync_bool_compare_and_swap(&mp->remote, head, obj) );
+
+	return 0;
+}
+
+int mempool_reclaim_remote(struct Mempool *mp)
+{
+	void *obj = NULL;
+	void *next = NULL;
+	int count = 0;
+
+	if( !mp || !mp->remote )
+	{
+		return 0;
+	}
+
+	/*the whole list is taken at once, so the pushes never race with a pop*/
+	obj = __sync_lock_test_and_set(&mp->remote, NULL);
+	for( ; obj; obj = next, count++)
+	{
+		next = *(void**)obj;
+		mempool_put_object(mp, obj);
+	}
+
+	return count;
+}
+
+int mempool_set_low_watermark(struct Mempool *mp, unsigned int watermark, lowWatermarkFunc func, void *userData)
+{
+	if( !mp || watermark >= mp->maxElementCount )
+	{
+		return -1;
+	}
+
+	mp->lowWatermark = watermark;
+	mp->lowData = userData;
+	mp->lowFunc = func;
+
+	return 0;
+}
+
 void mempool_free(struct Mempool *mp)
 {
 	if( !mp )
@@ -368,6 +476,7 @@ void mempool_free(struct Mempool *mp)
 		return;
 	}
 
+	mempool_reclaim_remote(mp);
 	return mp->ops.mempoolFree(mp);
 }
 
@@ -381,6 +490,7 @@ void mempool_release_unused(struct Mempool *mp)
 		return;
 	}
 
+	mempool_reclaim_remote(mp);
 	block = mp->block;
 	prev = mp->block;
 
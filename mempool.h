@@ -42,6 +42,8 @@ struct Mempool;
 
 typedef void* (*mallocFunc)(size_t size);
 typedef void (*freeFunc)(void *ptr);
+/*called when the free objects of mp fall to the low watermark, see mempool_set_low_watermark*/
+typedef void (*lowWatermarkFunc)(struct Mempool *mp, void *userData);
 
 /*
  * @Create mempool and init
@@ -82,6 +84,55 @@ void *mempool_get_object(struct Mempool *mp);
  */
 int mempool_put_object(struct Mempool *mp, void *obj);
 
+/*
+ * @Put the object back to a mempool owned by another thread
+ *
+ * The object is pushed to a lock-free list of the mempool, any thread may call it at any time. The
+ * owner takes the objects back into the mempool once it runs out of free objects or when it calls
+ * mempool_reclaim_remote, until then they still count as used.
+ *
+ * @param
+ *  mp: pointer to the Mempool the object was got from
+ *  obj: the pointer to the object to be released
+ *
+ * @return
+ *  0: success
+ *  -1: failed
+ */
+int mempool_put_object_remote(struct Mempool *mp, void *obj);
+
+/*
+ * @Take back the objects put by other threads, only the owner of the mempool may call it
+ *
+ * @param
+ *  mp: Mempool
+ *
+ * @return
+ *  the number of objects taken back
+ */
+int mempool_reclaim_remote(struct Mempool *mp);
+
+/*
+ * @Register a callback run when the mempool runs low
+ *
+ * When a get finds no more than watermark objects left to hand out, the objects put by other
+ * threads are taken back first. If that is not enough, func is called before the object is
+ * taken, so the objects it puts back can serve the get at once. func runs on the thread calling
+ * mempool_get_object and is not called again from within itself.
+ *
+ * @param
+ *  mp: Mempool
+ *  watermark: number of objects left, counting the blocks the mempool may still create, at
+ *   which func is called
+ *  func: callback freeing objects of the mempool, NULL removes it
+ *  userData: passed to func
+ *
+ * @return
+ *  0: success
+ *  -1: failed
+ */
+int mempool_set_low_watermark(struct Mempool *mp, unsigned int watermark, lowWatermarkFunc func, void *userData);
+
 /*
  * @Release the entire mempool
  *
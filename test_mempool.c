@@ -9,6 +9,7 @@
 #include <sys/wait.h>
 
 #include <rte_common.h>
+#include <rte_atomic.h>
 #include <rte_malloc.h>
 #include <rte_memory.h>
 #include <rte_memzone.h>
@@ -23,12 +24,31 @@
 #include "mempool.h"
 #include "hashTable.h"
 #include "hash.h"
+#include "hashTrace.h"
 
 #define RTE_PROC_MAX 2
 #define MEMPOOL_SIZE 1000000
 #define ELEMENT_SIZE 40 //48,16
 
 #define HASH_TABLE_SIZE 12000000
+/*operations replayed between two calls of hash_table_maintain*/
+#define REPLAY_MAINTAIN_OPS 1024
+
+#define UPSERT_KEYS 5000
+#define UPSERT_LCORES 4
+
+struct replay_stats
+{
+	uint64_t ops;
+	/*lookups finding the key and upserts updating it*/
+	uint64_t hit;
+	uint64_t miss;
+	/*inserts and upserts failing, also for want of an object*/
+	uint64_t failed;
+	/*operations with the result the traced table gave*/
+	uint64_t agree;
+	uint64_t cycles;
+} __rte_cache_aligned;
 
 typedef int (*pFunc)(void*);
 
@@ -41,6 +61,12 @@ struct lcore_conf
 
 	unsigned int ipStart;
 	pid_t pid;
+
+	/*replay, the traced lcores whose records this lcore replays*/
+	struct Mempool *mp;
+	unsigned int streamCount;
+	struct HashTraceStream *streams[RTE_MAX_LCORE];
+	struct replay_stats stats;
 };
 
 struct key
@@ -59,11 +85,28 @@ struct userData
 {
 	struct key k;
 	struct value v;
+	/*the lcore whose mempool the object came from*/
+	unsigned int lcore;
 };
 
 uint64_t g_cycles_per_second = 0;
 struct lcore_conf g_lcore_conf[RTE_MAX_LCORE];
 
+static struct hashTable *g_replay_htbl = NULL;
+static struct HashTraceFile *g_replay_trace = NULL;
+/*TSC of the first record of the trace*/
+static uint64_t g_replay_base = 0;
+/*the table copies key and value into its slots*/
+static int g_replay_inline = 0;
+static int g_replay_paced = 0;
+
+static struct hashTable *g_upsert_htbl = NULL;
+/*the objects each lcore upserts, one per key*/
+static struct userData g_upsert_obj[UPSERT_LCORES][UPSERT_KEYS];
+/*number of upserts of each key which inserted it*/
+static rte_atomic32_t g_upsert_new[UPSERT_KEYS];
+static rte_atomic32_t g_upsert_failed;
+
 static void assign_key(void *src, void *dst)
 {
 	struct key *s = (struct key*)src;
@@ -142,15 +185,32 @@ static void rte_free_wrap(void *addr)
 	}
 }
 
+static void rte_free_len_wrap(void *addr, __attribute__((unused))int len)
+{
+	rte_free_wrap(addr);
+}
+
+static unsigned int key_hash(void *key)
+{
+	return ((struct key*)key)->hashKey;
+}
+
 struct HashTableOps gHtblOps =
 {
 	.cmp = compare,
 	.hash = hash,
 	.mallocFunc = rte_malloc_wrap,
-	.freeFunc = rte_free_wrap,
+	.freeFunc = rte_free_len_wrap,
 	.assignKey = assign_key,
 	.assignValue = assign_value,
 	.assessFunc = NULL,
+	.expireFunc = NULL,
+	.keySize = sizeof(struct key),
+	.valueSize = sizeof(struct value),
+	.mallocSocketFunc = NULL,
+	.socket = 0,
+	.flags = 0,
+	.keyHashFunc = key_hash,
 };
 
 static int primary_process(__attribute__((unused))void *args)
@@ -251,11 +311,11 @@ static int secondary_process(__attribute__((unused))void *args)
 		memcpy(ipHostUa+uaLen, buf, strlen(buf));
 		copy += strlen(buf);
 		copy += generate_random_data(ipHostUa+copy, BUF_LEN-copy);
-		if( hash_table_find(htbl, ipHostUa, copy, (void*)&(obj->k), (void*)&(obj->v)) )
+		if( hash_table_find(htbl, ipHostUa, copy, (void*)&(obj->k), NULL, NULL) )
 		{
 			continue;
 		}
-		ret = hash_table_insert(htbl, (void*)ipHostUa, copy, (void*)&(obj->k), (void*)&(obj->v), 10*60*g_cycles_per_second);
+		ret = hash_table_insert(htbl, (void*)ipHostUa, copy, (void*)&(obj->k), (void*)&(obj->v), rte_rdtsc()+10*60*g_cycles_per_second);
 		switch(ret)
 		{
 			case RET_NEW:
@@ -275,6 +335,536 @@ static int secondary_process(__attribute__((unused))void *args)
 	exit(0);
 }
 
+/*objects of the list strategies go back to the mempool they came from, whichever lcore drops them*/
+static void replay_release(void *key, __attribute__((unused))void *value, __attribute__((unused))unsigned int owner)
+{
+	struct userData *obj = (struct userData*)key;
+	struct lcore_conf *lconf = NULL;
+
+	/*key and value are the slots of the table*/
+	if( g_replay_inline )
+	{
+		return;
+	}
+	lconf = &g_lcore_conf[obj->lcore];
+	if( obj->lcore == rte_lcore_id() )
+	{
+		mempool_put_object(lconf->mp, obj);
+	}
+	else
+	{
+		mempool_put_object_remote(lconf->mp, obj);
+	}
+}
+
+/*cycles of the trace converted to cycles of this process*/
+static uint64_t replay_cycles(uint64_t cycles)
+{
+	uint64_t hz = g_replay_trace->hz;
+
+	return cycles/hz*g_cycles_per_second + cycles%hz*g_cycles_per_second/hz;
+}
+
+/*the oldest record not replayed yet of the streams of the lcore, the streams are merged by TSC*/
+static struct HashTraceRecord *replay_next(struct lcore_conf *lconf, unsigned int *cursor)
+{
+	struct HashTraceRecord *rec = NULL;
+	struct HashTraceStream *stream = NULL;
+	unsigned int next = 0;
+	unsigned int i = 0;
+
+	for( ; i < lconf->streamCount; i++)
+	{
+		stream = lconf->streams[i];
+		if( cursor[i] < stream->count && (!rec || stream->rec[cursor[i]].tsc < rec->tsc) )
+		{
+			rec = &stream->rec[cursor[i]];
+			next = i;
+		}
+	}
+	if( rec )
+	{
+		cursor[next]++;
+	}
+
+	return rec;
+}
+
+static int replay_lcore(__attribute__((unused))void *args)
+{
+	struct lcore_conf *lconf = NULL;
+	struct replay_stats *st = NULL;
+	struct HashTraceRecord *rec = NULL;
+	struct userData *obj = NULL;
+	struct userData local;
+	struct HashSig sig;
+	unsigned int cursor[RTE_MAX_LCORE] = {0};
+	unsigned int lcore_id = rte_lcore_id();
+	uint64_t start = 0;
+	int result = 0;
+
+	lconf = &g_lcore_conf[lcore_id];
+	st = &lconf->stats;
+	start = rte_rdtsc();
+	while( (rec = replay_next(lconf, cursor)) != NULL )
+	{
+		/*the records keep the spacing they had when traced*/
+		while( g_replay_paced && rte_rdtsc() - start < replay_cycles(rec->tsc - g_replay_base) )
+		{
+			rte_pause();
+		}
+
+		obj = &local;
+		if( !g_replay_inline && (rec->op == HASH_TRACE_INSERT || rec->op == HASH_TRACE_UPSERT) )
+		{
+			obj = (struct userData*)mempool_get_object(lconf->mp);
+		}
+		if( obj )
+		{
+			memset(obj, 0x00, sizeof(struct userData));
+			obj->k.hashKey = rec->hash;
+			obj->k.verifyKey = rec->fingerprint;
+			obj->lcore = lcore_id;
+		}
+		sig.hash = rec->hash;
+
+		result = RET_FAILED;
+		switch( rec->op )
+		{
+			case HASH_TRACE_FIND:
+				result = hash_table_find_with_sig(g_replay_htbl, &sig, &obj->k, NULL, NULL) != NULL;
+				if( result )
+				{
+					st->hit++;
+				}
+				else
+				{
+					st->miss++;
+				}
+				break;
+			case HASH_TRACE_INSERT:
+			case HASH_TRACE_UPSERT:
+				if( !obj )
+				{
+					st->miss++;
+					break;
+				}
+				if( rec->op == HASH_TRACE_INSERT )
+				{
+					result = hash_table_insert_with_sig(g_replay_htbl, &sig, &obj->k, &obj->v, rte_rdtsc()+replay_cycles(rec->ttl));
+				}
+				else
+				{
+					result = hash_table_upsert_with_sig(g_replay_htbl, &sig, &obj->k, &obj->v, rte_rdtsc()+replay_cycles(rec->ttl), NULL, NULL);
+				}
+				if( result == RET_UPDATE )
+				{
+					st->hit++;
+				}
+				else
+				{
+					st->miss++;
+				}
+				if( result != RET_NEW && obj != &local )
+				{
+					mempool_put_object(lconf->mp, obj);
+				}
+				break;
+			case HASH_TRACE_DELETE:
+				result = hash_table_delete_with_sig(g_replay_htbl, &sig, &obj->k, NULL);
+				break;
+			default:
+				break;
+		}
+		if( result == RET_FAILED && (rec->op == HASH_TRACE_INSERT || rec->op == HASH_TRACE_UPSERT) )
+		{
+			st->failed++;
+		}
+		if( result == rec->result )
+		{
+			st->agree++;
+		}
+		if( ++st->ops % REPLAY_MAINTAIN_OPS == 0 )
+		{
+			mempool_reclaim_remote(lconf->mp);
+			hash_table_maintain(g_replay_htbl);
+		}
+	}
+	hash_table_flush(g_replay_htbl);
+	st->cycles = rte_rdtsc() - start;
+
+	return 0;
+}
+
+static void replay_report(const char *name, struct replay_stats *st, uint64_t cycles)
+{
+	double seconds = (double)cycles/g_cycles_per_second;
+
+	printf("%s: %lu ops, hit rate %.2f%%, %lu failed, %.2f%% as traced, %.3f Mops/s\n", name, st->ops,
+			st->hit+st->miss ? 100.0*st->hit/(st->hit+st->miss) : 0.0, st->failed,
+			st->ops ? 100.0*st->agree/st->ops : 0.0, seconds > 0 ? st->ops/seconds/1000000 : 0.0);
+}
+
+/*
+ * Replay a trace written by hash_trace_dump against a table of the given strategy and flags. The
+ * records of each traced lcore are replayed in order by one of the slave lcores. Unless paced the
+ * trace runs at full speed and the nodes then outlive as many more operations as the replay is faster.
+ */
+static int replay_trace(int argc, char *argv[])
+{
+	struct HashTableOps ops = gHtblOps;
+	struct HashTableStats hstats;
+	struct replay_stats total;
+	struct lcore_conf *lconf = NULL;
+	char name[32] = {0};
+	uint64_t records = 0;
+	uint64_t cycles = 0;
+	unsigned int capacity = 0;
+	unsigned int slaves = 0;
+	unsigned int mode = 0;
+	unsigned int lcore_id = 0;
+	unsigned int i = 0;
+	int ret = -1;
+
+	if( argc < 3 )
+	{
+		printf("Usage replay TRACE MODE [FLAGS [CAPACITY [paced]]]\n");
+		return -1;
+	}
+	mode = strtoul(argv[2], NULL, 0);
+	ops.flags = argc > 3 ? strtoul(argv[3], NULL, 0) : 0;
+	capacity = argc > 4 ? strtoul(argv[4], NULL, 0) : 0;
+	g_replay_paced = argc > 5 && !strcmp(argv[5], "paced");
+	g_replay_inline = mode == HASH_STRATEGY_INLINE;
+	ops.evictFunc = replay_release;
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id)
+	{
+		slaves++;
+	}
+	g_replay_trace = hash_trace_load(argv[1]);
+	if( !g_replay_trace || !slaves )
+	{
+		printf("No trace or no slave lcore to replay it!\n");
+		goto DONE;
+	}
+	memset(g_lcore_conf, 0x00, sizeof(g_lcore_conf));
+	g_replay_base = UINT64_MAX;
+	for( i = 0; i < g_replay_trace->count; i++)
+	{
+		records += g_replay_trace->stream[i].count;
+		if( g_replay_trace->stream[i].count )
+		{
+			g_replay_base = RTE_MIN(g_replay_base, g_replay_trace->stream[i].rec[0].tsc);
+		}
+	}
+	/*room for every key of the trace unless given*/
+	if( !capacity )
+	{
+		capacity = RTE_MAX(records, 1024ULL);
+	}
+
+	g_replay_htbl = hash_table_create(capacity, mode, &ops);
+	if( !g_replay_htbl )
+	{
+		goto DONE;
+	}
+	i = 0;
+	RTE_LCORE_FOREACH_SLAVE(lcore_id)
+	{
+		lconf = &g_lcore_conf[lcore_id];
+		lconf->mp = mempool_create(sizeof(struct userData), capacity/slaves*2 + 1024, rte_malloc_wrap, rte_free_wrap);
+		if( !lconf->mp )
+		{
+			goto DONE;
+		}
+	}
+	/*the traced lcores are dealt round robin*/
+	for( i = 0; i < g_replay_trace->count; )
+	{
+		RTE_LCORE_FOREACH_SLAVE(lcore_id)
+		{
+			if( i < g_replay_trace->count )
+			{
+				lconf = &g_lcore_conf[lcore_id];
+				lconf->streams[lconf->streamCount++] = &g_replay_trace->stream[i++];
+			}
+		}
+	}
+
+	rte_eal_mp_remote_launch(replay_lcore, NULL, SKIP_MASTER);
+	memset(&total, 0x00, sizeof(total));
+	RTE_LCORE_FOREACH_SLAVE(lcore_id)
+	{
+		if( rte_eal_wait_lcore(lcore_id) < 0 )
+		{
+			printf("lcore %u failed!\n", lcore_id);
+		}
+		lconf = &g_lcore_conf[lcore_id];
+		snprintf(name, sizeof(name), "lcore %u", lcore_id);
+		replay_report(name, &lconf->stats, lconf->stats.cycles);
+		total.ops += lconf->stats.ops;
+		total.hit += lconf->stats.hit;
+		total.miss += lconf->stats.miss;
+		total.failed += lconf->stats.failed;
+		total.agree += lconf->stats.agree;
+		cycles = RTE_MAX(cycles, lconf->stats.cycles);
+	}
+	replay_report("total", &total, cycles);
+	if( hash_table_stats(g_replay_htbl, &hstats) == 0 )
+	{
+		printf("table: %lu evicted, %lu expired, %lu rejected, %lu collisions\n", hstats.eviction, hstats.expiration,
+				hstats.rejected, hstats.collision);
+	}
+	ret = 0;
+
+DONE:
+	/*the objects the table still holds are not given back, the mempools go away with the process*/
+	hash_table_destroy(g_replay_htbl);
+	hash_trace_unload(g_replay_trace);
+	return ret;
+}
+
+/*
+ * A key taking the expired node of another key in its chain must be found afterwards and must
+ * not be inserted a second time
+ */
+static int test_expired_reuse(enum HASH_STRATEGY mode)
+{
+	static struct userData obj[3];
+	struct hashTable *htbl = NULL;
+	struct HashSig sig[2];
+	struct key k;
+	int ret = -1;
+
+	memset(obj, 0x00, sizeof(obj));
+	htbl = hash_table_create(1024, mode, &gHtblOps);
+	if( !htbl )
+	{
+		return -1;
+	}
+
+	/*two hash values of the same home slot*/
+	sig[0].hash = 7;
+	sig[1].hash = 7 + hash_table_slots(htbl);
+	obj[0].k.hashKey = sig[0].hash;
+	obj[0].k.verifyKey = 1;
+	obj[1].k.hashKey = sig[1].hash;
+	obj[1].k.verifyKey = 2;
+	obj[2].k = obj[1].k;
+	k = obj[1].k;
+
+	if( hash_table_insert_with_sig(htbl, &sig[0], &obj[0].k, &obj[0].v, rte_rdtsc()) == RET_FAILED )
+	{
+		goto DONE;
+	}
+	if( hash_table_insert_with_sig(htbl, &sig[1], &obj[1].k, &obj[1].v, rte_rdtsc()+g_cycles_per_second) == RET_FAILED )
+	{
+		goto DONE;
+	}
+	if( !hash_table_find_with_sig(htbl, &sig[1], &k, NULL, NULL) )
+	{
+		printf("Mode %d: the key reusing an expired node is not found!\n", mode);
+		goto DONE;
+	}
+	if( hash_table_insert_with_sig(htbl, &sig[1], &obj[2].k, &obj[2].v, rte_rdtsc()+g_cycles_per_second) == RET_NEW )
+	{
+		printf("Mode %d: the key reusing an expired node is inserted twice!\n", mode);
+		goto DONE;
+	}
+	ret = 0;
+
+DONE:
+	hash_table_destroy(htbl);
+	return ret;
+}
+
+/*a key already in a later probe group is written in place when inserted again, not a second time*/
+static int test_inline_reinsert(void)
+{
+#define REINSERT_KEYS 64
+	struct hashTable *htbl = NULL;
+	struct HashSig sig;
+	struct key k;
+	struct value v;
+	unsigned int count = 0;
+	int ret = -1;
+
+	htbl = hash_table_create(1024, HASH_STRATEGY_INLINE, &gHtblOps);
+	if( !htbl )
+	{
+		return -1;
+	}
+
+	/*keys of the same hash value fill the home group and go on in the next ones*/
+	memset(&v, 0x00, sizeof(v));
+	sig.hash = 0;
+	k.hashKey = sig.hash;
+	for( ; count < REINSERT_KEYS; count++)
+	{
+		k.verifyKey = count;
+		if( hash_table_insert_key(htbl, &k, &v, rte_rdtsc()+g_cycles_per_second) != RET_NEW )
+		{
+			break;
+		}
+	}
+	if( count < 2 )
+	{
+		goto DONE;
+	}
+
+	k.verifyKey = 0;
+	hash_table_delete_with_sig(htbl, &sig, &k, NULL);
+	k.verifyKey = count - 1;
+	if( hash_table_insert_key(htbl, &k, &v, rte_rdtsc()+g_cycles_per_second) == RET_NEW )
+	{
+		printf("Inline: a key of a later probe group is inserted twice!\n");
+		goto DONE;
+	}
+	hash_table_delete_with_sig(htbl, &sig, &k, NULL);
+	if( hash_table_find_with_sig(htbl, &sig, &k, NULL, NULL) )
+	{
+		printf("Inline: a deleted key is still found!\n");
+		goto DONE;
+	}
+	ret = 0;
+
+DONE:
+	hash_table_destroy(htbl);
+	return ret;
+}
+
+static void upsert_init(void *v, __attribute__((unused))void *userData)
+{
+	((struct value*)v)->count = 1;
+}
+
+/*runs under the write lock of the node, no update may be lost*/
+static void upsert_update(void *v, __attribute__((unused))void *userData)
+{
+	((struct value*)v)->count++;
+}
+
+static void upsert_key(struct key *k, unsigned int i)
+{
+	k->hashKey = i*2654435761u;
+	k->verifyKey = i;
+}
+
+static int upsert_lcore(__attribute__((unused))void *args)
+{
+	struct UpsertCallBack cb = {upsert_init, upsert_update, NULL};
+	struct userData *obj = NULL;
+	struct HashSig sig;
+	unsigned int idx = rte_lcore_index(rte_lcore_id());
+	unsigned int i = 0;
+	int ret = 0;
+
+	if( idx >= UPSERT_LCORES )
+	{
+		return 0;
+	}
+	for( ; i < UPSERT_KEYS; i++)
+	{
+		obj = &g_upsert_obj[idx][i];
+		upsert_key(&obj->k, i);
+		sig.hash = obj->k.hashKey;
+		ret = hash_table_upsert_with_sig(g_upsert_htbl, &sig, &obj->k, &obj->v, rte_rdtsc()+g_cycles_per_second*60, &cb, NULL);
+		if( ret == RET_NEW || ret == RET_OCCUPY )
+		{
+			rte_atomic32_inc(&g_upsert_new[i]);
+		}
+		else if( ret != RET_UPDATE )
+		{
+			rte_atomic32_inc(&g_upsert_failed);
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Every lcore upserts the same keys at once, each key must be inserted by exactly one of them and
+ * updated by all the others
+ */
+static int test_upsert_unique(enum HASH_STRATEGY mode)
+{
+	struct HashNodeCopy cp;
+	struct HashSig sig;
+	struct key k;
+	struct value v;
+	unsigned int expected = RTE_MIN(rte_lcore_count(), UPSERT_LCORES);
+	unsigned int lcore_id = 0;
+	unsigned int i = 0;
+	int ret = -1;
+
+	/*room enough that no node is evicted*/
+	g_upsert_htbl = hash_table_create(UPSERT_KEYS*8, mode, &gHtblOps);
+	if( !g_upsert_htbl )
+	{
+		return -1;
+	}
+	memset(g_upsert_obj, 0x00, sizeof(g_upsert_obj));
+	for( ; i < UPSERT_KEYS; i++)
+	{
+		rte_atomic32_init(&g_upsert_new[i]);
+	}
+	rte_atomic32_init(&g_upsert_failed);
+
+	rte_eal_mp_remote_launch(upsert_lcore, NULL, CALL_MASTER);
+	RTE_LCORE_FOREACH_SLAVE(lcore_id)
+	{
+		rte_eal_wait_lcore(lcore_id);
+	}
+
+	if( rte_atomic32_read(&g_upsert_failed) )
+	{
+		printf("Mode %d: %d upserts failed!\n", mode, rte_atomic32_read(&g_upsert_failed));
+		goto DONE;
+	}
+	for( i = 0; i < UPSERT_KEYS; i++)
+	{
+		if( rte_atomic32_read(&g_upsert_new[i]) != 1 )
+		{
+			printf("Mode %d: key %u is inserted %d times!\n", mode, i, rte_atomic32_read(&g_upsert_new[i]));
+			goto DONE;
+		}
+		upsert_key(&k, i);
+		sig.hash = k.hashKey;
+		memset(&v, 0x00, sizeof(v));
+		cp.expired = 0;
+		cp.value = &v;
+		if( !hash_table_find_with_sig(g_upsert_htbl, &sig, &k, &cp, NULL) || v.count != expected )
+		{
+			printf("Mode %d: key %u counts %u of %u upserts!\n", mode, i, v.count, expected);
+			goto DONE;
+		}
+	}
+	ret = 0;
+
+DONE:
+	hash_table_destroy(g_upsert_htbl);
+	g_upsert_htbl = NULL;
+	return ret;
+}
+
+static void test_hash_table(void)
+{
+	int mode = 0;
+
+	for( ; mode < HASH_STRATEGY_MAX; mode++)
+	{
+		if( test_upsert_unique((enum HASH_STRATEGY)mode) < 0 )
+		{
+			return;
+		}
+	}
+	if( test_expired_reuse(HASH_STRATEGY_ROBINHOOD) == 0 && test_inline_reinsert() == 0 )
+	{
+		printf("Hash table checks passed\n");
+	}
+}
+
 static void test_mempool(unsigned int cnt)
 {
 	struct timeval t1;
@@ -377,7 +967,7 @@ int main(int argc, char *argv[])
 
 	if( argc < 2 )
 	{
-		printf("Usage %s COUNT\n", argv[0]);
+		printf("Usage %s COUNT | replay TRACE MODE [FLAGS [CAPACITY [paced]]]\n", argv[0]);
 		return 0;
 	}
 
@@ -395,8 +985,13 @@ int main(int argc, char *argv[])
 	switch(cfg->process_type )
 	{
 		case RTE_PROC_PRIMARY:
+			if( !strcmp(argv[1], "replay") )
+			{
+				return replay_trace(argc-1, argv+1);
+			}
 			cnt = atoi(argv[1]);
 			test_mempool(cnt);
+			test_hash_table();
 			/*rte_eal_mp_remote_launch( primary_process, NULL, SKIP_MASTER);*/
 			primary_process(NULL);
 			RTE_LCORE_FOREACH_SLAVE(lcore_id)
@@ -416,7 +1011,7 @@ int main(int argc, char *argv[])
 			int idx = 0;
 			int ret = 0;
 
-			htbl = hash_table_create( HASH_TABLE_SIZE, &gHtblOps); 
+			htbl = hash_table_create( HASH_TABLE_SIZE, HASH_STRATEGY_SELF_EXPIRED, &gHtblOps); 
 			memset(g_lcore_conf, 0x00, sizeof(g_lcore_conf));
 			for( ; i < RTE_MAX_LCORE; i++)
 			{